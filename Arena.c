@@ -0,0 +1,186 @@
+/**
+* @file Arena.c
+* @version 1.0
+*
+* @brief A bump allocator for items of any size, that are all released together.
+*
+* @section DESCRIPTION
+* The chunks grow geometrically up to the size of a huge page. An item that is too big for a
+* chunk of its own size class gets a chunk of its own, so it does not waste the rest of the
+* current chunk.
+*/
+
+// ------------------------------ includes ------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "Arena.h"
+
+// -------------------------- const definitions -------------------------
+
+// The error massage that is to be printed if an error occurred when using malloc
+#define ERR_MALLOC "Memory allocation failed\n"
+
+// The size of the chunk header, rounded so the items after it are aligned for any type
+#define ARENA_HEADER_SIZE ((sizeof(SlabChunk) + 15) / 16 * 16)
+
+// The size of the first chunk of an arena
+#define FIRST_CHUNK_SIZE ((size_t) 4096)
+
+// The biggest size of a chunk that is shared by many items
+#define MAX_CHUNK_SIZE ((size_t) 2 * 1024 * 1024)
+
+// An item bigger than this part of a chunk gets a chunk of its own
+#define BIG_ITEM_PART (4)
+
+// ------------------------------ functions -----------------------------
+
+/**
+ * initializes an empty arena. no memory is allocated until the first item is asked for.
+ * @param arena: the arena to initialize.
+ * @param allocator: where to get the chunks from (may be NULL for malloc). it must live as long as
+ * the arena.
+ */
+void initArena(Arena *arena, const Allocator *allocator)
+{
+    arena->chunks = NULL;
+    arena->bump = NULL;
+    arena->end = NULL;
+    arena->nextChunkSize = FIRST_CHUNK_SIZE;
+    arena->allocator = allocator;
+    arena->chunkBytes = 0;
+    arena->usedBytes = 0;
+}
+
+/**
+ * @brief rounds the given address up to the given alignment
+ * @param address the address to round
+ * @param alignment a power of 2
+ * @return the rounded address
+ */
+uintptr_t arenaAlignUp(uintptr_t address, size_t alignment)
+{
+    return (address + alignment - 1) & ~(uintptr_t) (alignment - 1);
+}
+
+/**
+ * @brief allocates a chunk with room for the given amount of bytes after its header
+ * @param arena the arena to allocate the chunk for
+ * @param bytes the room that is needed
+ * @return the new chunk, or NULL if the allocation failed
+ */
+SlabChunk *newArenaChunk(Arena *arena, size_t bytes)
+{
+    const Allocator *allocator = arena->allocator;
+    SlabChunk *chunk = (SlabChunk *) (allocator != NULL
+                                      ? allocator->alloc(ARENA_HEADER_SIZE + bytes,
+                                                         allocator->context)
+                                      : malloc(ARENA_HEADER_SIZE + bytes));
+    if (chunk == NULL)
+    {
+        fprintf(stderr, "%s", ERR_MALLOC);
+        return NULL;
+    }
+    chunk->bytes = ARENA_HEADER_SIZE + bytes;
+    chunk->isMapped = 0;
+    arena->chunkBytes += chunk->bytes;
+    return chunk;
+}
+
+/**
+ * allocates an item from the arena.
+ * @param arena: the arena to allocate from.
+ * @param size: the size of the item in bytes.
+ * @param alignment: the alignment of the item (a power of 2, 1 for strings).
+ * @return: a pointer to the item, or NULL if the allocation failed.
+ */
+void *arenaAlloc(Arena *arena, size_t size, size_t alignment)
+{
+    if (arena->bump != NULL)
+    {
+        uintptr_t aligned = arenaAlignUp((uintptr_t) arena->bump, alignment);
+        if (aligned <= (uintptr_t) arena->end && (uintptr_t) arena->end - aligned >= size)
+        {
+            arena->bump = (char *) aligned + size;
+            arena->usedBytes += size;
+            return (void *) aligned;
+        }
+    }
+    if (size + alignment > arena->nextChunkSize / BIG_ITEM_PART)
+    {
+        // a chunk of its own, kept behind the current chunk so the current one is still used
+        SlabChunk *chunk = newArenaChunk(arena, size + alignment);
+        if (chunk == NULL)
+        {
+            return NULL;
+        }
+        if (arena->chunks == NULL)
+        {
+            chunk->next = NULL;
+            arena->chunks = chunk;
+        }
+        else
+        {
+            chunk->next = arena->chunks->next;
+            arena->chunks->next = chunk;
+        }
+        arena->usedBytes += size;
+        return (void *) arenaAlignUp((uintptr_t) chunk + ARENA_HEADER_SIZE, alignment);
+    }
+    SlabChunk *chunk = newArenaChunk(arena, arena->nextChunkSize);
+    if (chunk == NULL)
+    {
+        return NULL;
+    }
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+    arena->bump = (char *) chunk + ARENA_HEADER_SIZE;
+    arena->end = (char *) chunk + chunk->bytes;
+    if (arena->nextChunkSize < MAX_CHUNK_SIZE)
+    {
+        arena->nextChunkSize *= 2;
+    }
+    return arenaAlloc(arena, size, alignment);
+}
+
+/**
+ * moves all the chunks of an arena to another arena, so they are freed with it. the items of the
+ * moved chunks stay valid, but are not counted as used by the other arena. takes O(chunks).
+ * @param arena: the arena to move the chunks to. it must have the same allocator.
+ * @param from: the arena to take the chunks from. it is left empty.
+ */
+void arenaAdopt(Arena *arena, Arena *from)
+{
+    // the moved chunks go after the current chunk, so it keeps handing out items
+    SlabChunk **tail = &arena->chunks;
+    while (*tail != NULL)
+    {
+        tail = &(*tail)->next;
+    }
+    *tail = from->chunks;
+    arena->chunkBytes += from->chunkBytes;
+    initArena(from, from->allocator);
+}
+
+/**
+ * frees all the chunks of the arena, and with them all of its items.
+ * @param arena: the arena to free.
+ */
+void freeArena(Arena *arena)
+{
+    SlabChunk *chunk = arena->chunks;
+    while (chunk != NULL)
+    {
+        SlabChunk *next = chunk->next;
+        if (arena->allocator != NULL)
+        {
+            arena->allocator->free(chunk, chunk->bytes, arena->allocator->context);
+        }
+        else
+        {
+            free(chunk);
+        }
+        chunk = next;
+    }
+    initArena(arena, arena->allocator);
+}
@@ -0,0 +1,64 @@
+/**
+* @file Arena.h
+* @version 1.0
+*
+* @brief A bump allocator for items of any size, that are all released together.
+*
+* @section DESCRIPTION
+* Items are carved one after the other out of big chunks, so they take no allocation header and
+* lie next to each other in memory. There is no way to free a single item: the whole arena is
+* released at once by freeing its chunks.
+*/
+
+#ifndef RBTREE_ARENA_H
+#define RBTREE_ARENA_H
+
+#include <stddef.h>
+#include "Slab.h"
+
+/**
+ * an arena of items of any size.
+ * chunkBytes counts the memory of all the chunks, and usedBytes the sizes of the items in them.
+ */
+typedef struct Arena
+{
+	SlabChunk *chunks;
+	char *bump, *end;
+	size_t nextChunkSize;
+	const Allocator *allocator;
+	size_t chunkBytes;
+	size_t usedBytes;
+} Arena;
+
+/**
+ * initializes an empty arena. no memory is allocated until the first item is asked for.
+ * @param arena: the arena to initialize.
+ * @param allocator: where to get the chunks from (may be NULL for malloc). it must live as long as
+ * the arena.
+ */
+void initArena(Arena *arena, const Allocator *allocator);
+
+/**
+ * allocates an item from the arena.
+ * @param arena: the arena to allocate from.
+ * @param size: the size of the item in bytes.
+ * @param alignment: the alignment of the item (a power of 2, 1 for strings).
+ * @return: a pointer to the item, or NULL if the allocation failed.
+ */
+void *arenaAlloc(Arena *arena, size_t size, size_t alignment);
+
+/**
+ * moves all the chunks of an arena to another arena, so they are freed with it. the items of the
+ * moved chunks stay valid, but are not counted as used by the other arena. takes O(chunks).
+ * @param arena: the arena to move the chunks to. it must have the same allocator.
+ * @param from: the arena to take the chunks from. it is left empty.
+ */
+void arenaAdopt(Arena *arena, Arena *from);
+
+/**
+ * frees all the chunks of the arena, and with them all of its items.
+ * @param arena: the arena to free.
+ */
+void freeArena(Arena *arena);
+
+#endif //RBTREE_ARENA_H
@@ -0,0 +1,408 @@
+/**
+* @file CompactRBTree.c
+* @version 1.0
+*
+* @brief A Red Black Tree with a compact node layout, for big trees that are mostly searched.
+*
+* @section DESCRIPTION
+* The nodes are kept in one growing array and link to each other by their indices in it, so
+* growing the array never breaks the links. The index 0 is a black sentinel that stands for a
+* missing child or parent.
+*/
+
+// ------------------------------ includes ------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include "CompactRBTree.h"
+
+// -------------------------- const definitions -------------------------
+
+// The start size of a tree
+#define START_SIZE (0)
+
+// The amount of nodes the array of a new tree has room for (including the sentinel)
+#define START_CAPACITY (16)
+
+// The index that stands for no node
+#define NIL (0)
+
+// The biggest amount of nodes a tree can hold, so an index still fits in a parent link
+#define MAX_NODES ((uint32_t) INT32_MAX)
+
+// The error massage that is to be printed if an error occurred when using malloc
+#define ERR_MALLOC "Memory allocation failed\n"
+
+// Stands for success or failure of a function
+#define FAILURE (0)
+#define SUCCESS (1)
+
+// ------------------------------ functions -----------------------------
+
+/**
+ * constructs a new CompactRBTree with the given CompareFunc.
+ * @param compFunc: a function two compare two variables.
+ * @param freeFunc: a function to free the items of the tree (may be NULL).
+ * @return: the new tree, or NULL on failure.
+ */
+CompactRBTree *newCompactRBTree(CompareFunc compFunc, FreeFunc freeFunc)
+{
+    CompactRBTree *newTree = (CompactRBTree *) malloc(sizeof(CompactRBTree));
+    if (newTree == NULL)
+    {
+        fprintf(stderr, "%s", ERR_MALLOC);
+        return NULL;
+    }
+    newTree->nodes = (CompactNode *) malloc(START_CAPACITY * sizeof(CompactNode));
+    if (newTree->nodes == NULL)
+    {
+        fprintf(stderr, "%s", ERR_MALLOC);
+        free(newTree);
+        return NULL;
+    }
+    newTree->nodes[NIL].data = NULL;
+    newTree->nodes[NIL].left = NIL;
+    newTree->nodes[NIL].right = NIL;
+    newTree->nodes[NIL].parentColor = BLACK;
+    newTree->capacity = START_CAPACITY;
+    newTree->used = 1;
+    newTree->root = NIL;
+    newTree->compFunc = compFunc;
+    newTree->freeFunc = freeFunc;
+    newTree->size = START_SIZE;
+    return newTree;
+}
+
+/**
+ * @brief returns the index of the parent of the given node
+ * @param tree the tree the node is in
+ * @param node the index of the node
+ * @return the index of its parent, NIL for the root
+ */
+uint32_t compactParent(const CompactRBTree *tree, uint32_t node)
+{
+    return tree->nodes[node].parentColor >> 1u;
+}
+
+/**
+ * @brief returns the color of the given node (NIL is black)
+ * @param tree the tree the node is in
+ * @param node the index of the node
+ * @return the color of the node
+ */
+Color compactColor(const CompactRBTree *tree, uint32_t node)
+{
+    return (Color) (tree->nodes[node].parentColor & 1u);
+}
+
+/**
+ * @brief links the given node to a new parent, keeping its color
+ * @param tree the tree the node is in
+ * @param node the index of the node, must not be NIL
+ * @param parent the index of the new parent
+ */
+void compactSetParent(CompactRBTree *tree, uint32_t node, uint32_t parent)
+{
+    tree->nodes[node].parentColor = (parent << 1u) | (tree->nodes[node].parentColor & 1u);
+}
+
+/**
+ * @brief colors the given node, keeping its parent
+ * @param tree the tree the node is in
+ * @param node the index of the node, must not be NIL
+ * @param color the new color
+ */
+void compactSetColor(CompactRBTree *tree, uint32_t node, Color color)
+{
+    tree->nodes[node].parentColor = (tree->nodes[node].parentColor & ~1u) | (uint32_t) color;
+}
+
+/**
+ * @brief puts the given child in the place of the old child of the given parent
+ * @param tree the tree to do the change in
+ * @param parent the parent of the old child, NIL if the old child is the root
+ * @param oldChild the child to replace
+ * @param newChild the child to put instead
+ */
+void compactReplaceChild(CompactRBTree *tree, uint32_t parent, uint32_t oldChild,
+                         uint32_t newChild)
+{
+    if (parent == NIL)
+    {
+        tree->root = newChild;
+    }
+    else if (tree->nodes[parent].left == oldChild)
+    {
+        tree->nodes[parent].left = newChild;
+    }
+    else
+    {
+        tree->nodes[parent].right = newChild;
+    }
+    if (newChild != NIL)
+    {
+        compactSetParent(tree, newChild, parent);
+    }
+}
+
+/**
+ * @brief rotates the given node to the left, so its right child takes its place
+ * @param tree the tree to do the change in
+ * @param node the node to rotate, must have a right child
+ */
+void compactRotateLeft(CompactRBTree *tree, uint32_t node)
+{
+    uint32_t child = tree->nodes[node].right;
+    tree->nodes[node].right = tree->nodes[child].left;
+    if (tree->nodes[child].left != NIL)
+    {
+        compactSetParent(tree, tree->nodes[child].left, node);
+    }
+    compactReplaceChild(tree, compactParent(tree, node), node, child);
+    tree->nodes[child].left = node;
+    compactSetParent(tree, node, child);
+}
+
+/**
+ * @brief rotates the given node to the right, so its left child takes its place
+ * @param tree the tree to do the change in
+ * @param node the node to rotate, must have a left child
+ */
+void compactRotateRight(CompactRBTree *tree, uint32_t node)
+{
+    uint32_t child = tree->nodes[node].left;
+    tree->nodes[node].left = tree->nodes[child].right;
+    if (tree->nodes[child].right != NIL)
+    {
+        compactSetParent(tree, tree->nodes[child].right, node);
+    }
+    compactReplaceChild(tree, compactParent(tree, node), node, child);
+    tree->nodes[child].right = node;
+    compactSetParent(tree, node, child);
+}
+
+/**
+ * @brief modifies the given tree that was made unbalanced when the given red node was added
+ * @param tree the tree to do the changes in
+ * @param node the node that was added
+ */
+void compactModifyNode(CompactRBTree *tree, uint32_t node)
+{
+    while (compactColor(tree, compactParent(tree, node)) == RED)
+    {
+        uint32_t parent = compactParent(tree, node);
+        uint32_t grandparent = compactParent(tree, parent); // exists because parent is red
+        int parentIsLeft = tree->nodes[grandparent].left == parent;
+        uint32_t uncle = parentIsLeft ? tree->nodes[grandparent].right
+                                      : tree->nodes[grandparent].left;
+        // parent is red and uncle is red
+        if (compactColor(tree, uncle) == RED)
+        {
+            compactSetColor(tree, parent, BLACK);
+            compactSetColor(tree, uncle, BLACK);
+            compactSetColor(tree, grandparent, RED);
+            node = grandparent;
+            continue;
+        }
+        // parent is red and uncle is black
+        if (parentIsLeft)
+        {
+            if (tree->nodes[parent].right == node)
+            {
+                compactRotateLeft(tree, parent);
+                parent = node;
+            }
+            compactRotateRight(tree, grandparent);
+        }
+        else
+        {
+            if (tree->nodes[parent].left == node)
+            {
+                compactRotateRight(tree, parent);
+                parent = node;
+            }
+            compactRotateLeft(tree, grandparent);
+        }
+        compactSetColor(tree, parent, BLACK);
+        compactSetColor(tree, grandparent, RED);
+        break;
+    }
+    compactSetColor(tree, tree->root, BLACK);
+}
+
+/**
+ * @brief makes sure the array of the tree has room for one more node
+ * @param tree the tree to grow
+ * @return 1 on success, 0 if the allocation failed or the tree is full
+ */
+int compactReserveNode(CompactRBTree *tree)
+{
+    if (tree->used < tree->capacity)
+    {
+        return SUCCESS;
+    }
+    if (tree->capacity >= MAX_NODES)
+    {
+        return FAILURE;
+    }
+    uint32_t newCapacity = tree->capacity > MAX_NODES / 2 ? MAX_NODES : tree->capacity * 2;
+    CompactNode *newNodes = (CompactNode *) realloc(tree->nodes,
+                                                    (size_t) newCapacity * sizeof(CompactNode));
+    if (newNodes == NULL)
+    {
+        fprintf(stderr, "%s", ERR_MALLOC);
+        return FAILURE;
+    }
+    tree->nodes = newNodes;
+    tree->capacity = newCapacity;
+    return SUCCESS;
+}
+
+/**
+ * add an item to the tree
+ * @param tree: the tree to add an item to.
+ * @param data: item to add to the tree.
+ * @return: 0 on failure, other on success. (if the item is already in the tree - failure).
+ */
+int addToCompactRBTree(CompactRBTree *tree, void *data)
+{
+    if (tree == NULL)
+    {
+        return FAILURE;
+    }
+    uint32_t parent = NIL;
+    uint32_t curNode = tree->root;
+    int compare = 0;
+    while (curNode != NIL)
+    {
+        compare = tree->compFunc(data, tree->nodes[curNode].data);
+        if (compare == 0)
+        {
+            return FAILURE;
+        }
+        parent = curNode;
+        curNode = compare < 0 ? tree->nodes[curNode].left : tree->nodes[curNode].right;
+    }
+    if (compactReserveNode(tree) == FAILURE)
+    {
+        return FAILURE;
+    }
+    uint32_t newNode = tree->used++;
+    tree->nodes[newNode].data = data;
+    tree->nodes[newNode].left = NIL;
+    tree->nodes[newNode].right = NIL;
+    tree->nodes[newNode].parentColor = (parent << 1u) | (uint32_t) RED;
+    if (parent == NIL)
+    {
+        tree->root = newNode;
+    }
+    else if (compare < 0)
+    {
+        tree->nodes[parent].left = newNode;
+    }
+    else
+    {
+        tree->nodes[parent].right = newNode;
+    }
+    compactModifyNode(tree, newNode);
+    tree->size += 1;
+    return SUCCESS;
+}
+
+/**
+ * check whether the tree contains this item.
+ * @param tree: the tree to search in.
+ * @param data: item to check.
+ * @return: 0 if the item is not in the tree, other if it is.
+ */
+int containsCompactRBTree(CompactRBTree *tree, void *data)
+{
+    if (tree == NULL || data == NULL)
+    {
+        return FAILURE;
+    }
+    const CompactNode *nodes = tree->nodes;
+    uint32_t curNode = tree->root;
+    while (curNode != NIL)
+    {
+        int comp = tree->compFunc(nodes[curNode].data, data);
+        if (comp == 0)
+        {
+            return SUCCESS;
+        }
+        curNode = comp > 0 ? nodes[curNode].left : nodes[curNode].right;
+    }
+    return FAILURE;
+}
+
+/**
+ * Activate a function on each item of the tree. the order is an ascending order. if one of the activations of the
+ * function returns 0, the process stops.
+ * @param tree: the tree with all the items.
+ * @param func: the function to activate on all items.
+ * @param args: more optional arguments to the function (may be null if the given function support it).
+ * @return: 0 on failure, other on success.
+ */
+int forEachCompactRBTree(CompactRBTree *tree, forEachFunc func, void *args)
+{
+    if (tree == NULL || func == NULL)
+    {
+        return FAILURE;
+    }
+    const CompactNode *nodes = tree->nodes;
+    uint32_t curNode = tree->root;
+    while (curNode != NIL && nodes[curNode].left != NIL)
+    {
+        curNode = nodes[curNode].left;
+    }
+    while (curNode != NIL)
+    {
+        if (func(nodes[curNode].data, args) == 0)
+        {
+            return FAILURE;
+        }
+        // move to the successor: the leftmost node of the right subtree, or the first ancestor
+        // that we reach from its left
+        if (nodes[curNode].right != NIL)
+        {
+            curNode = nodes[curNode].right;
+            while (nodes[curNode].left != NIL)
+            {
+                curNode = nodes[curNode].left;
+            }
+        }
+        else
+        {
+            uint32_t child = curNode;
+            curNode = compactParent(tree, curNode);
+            while (curNode != NIL && nodes[curNode].right == child)
+            {
+                child = curNode;
+                curNode = compactParent(tree, curNode);
+            }
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * free all memory of the data structure.
+ * @param tree: the tree to free.
+ */
+void freeCompactRBTree(CompactRBTree *tree)
+{
+    if (tree != NULL)
+    {
+        if (tree->freeFunc != NULL)
+        {
+            for (uint32_t i = 1; i < tree->used; i++)
+            {
+                if (tree->nodes[i].data != NULL)
+                {
+                    tree->freeFunc(tree->nodes[i].data);
+                }
+            }
+        }
+        free(tree->nodes);
+        free(tree);
+    }
+}
@@ -0,0 +1,85 @@
+/**
+* @file CompactRBTree.h
+* @version 1.0
+*
+* @brief A Red Black Tree with a compact node layout, for big trees that are mostly searched.
+*
+* @section DESCRIPTION
+* The nodes live in one array owned by the tree, and link to each other with 32 bit indices into
+* it instead of pointers. The color of a node is kept in the lowest bit of its parent link, so a
+* node takes 24 bytes (instead of the 40 bytes of a Node and the malloc header around it), and
+* more nodes share every cache line during a search.
+*/
+
+#ifndef RBTREE_COMPACTRBTREE_H
+#define RBTREE_COMPACTRBTREE_H
+
+#include <stdint.h>
+#include "RBTree.h"
+
+/*
+ * a node of the compact tree. the index 0 stands for no node.
+ * parentColor: the index of the parent shifted left by one, and the color in the lowest bit.
+ */
+typedef struct CompactNode
+{
+	void *data;
+	uint32_t left, right;
+	uint32_t parentColor;
+} CompactNode;
+
+/**
+ * represents the compact tree
+ * nodes[0] is a black sentinel, so the index 0 can be used as a black leaf.
+ */
+typedef struct CompactRBTree
+{
+	CompactNode *nodes;
+	uint32_t capacity, used;
+	uint32_t root;
+	CompareFunc compFunc;
+	FreeFunc freeFunc;
+	int size;
+} CompactRBTree;
+
+/**
+ * constructs a new CompactRBTree with the given CompareFunc.
+ * @param compFunc: a function two compare two variables.
+ * @param freeFunc: a function to free the items of the tree (may be NULL).
+ * @return: the new tree, or NULL on failure.
+ */
+CompactRBTree *newCompactRBTree(CompareFunc compFunc, FreeFunc freeFunc);
+
+/**
+ * add an item to the tree
+ * @param tree: the tree to add an item to.
+ * @param data: item to add to the tree.
+ * @return: 0 on failure, other on success. (if the item is already in the tree - failure).
+ */
+int addToCompactRBTree(CompactRBTree *tree, void *data);
+
+/**
+ * check whether the tree contains this item.
+ * @param tree: the tree to search in.
+ * @param data: item to check.
+ * @return: 0 if the item is not in the tree, other if it is.
+ */
+int containsCompactRBTree(CompactRBTree *tree, void *data);
+
+/**
+ * Activate a function on each item of the tree. the order is an ascending order. if one of the activations of the
+ * function returns 0, the process stops.
+ * @param tree: the tree with all the items.
+ * @param func: the function to activate on all items.
+ * @param args: more optional arguments to the function (may be null if the given function support it).
+ * @return: 0 on failure, other on success.
+ */
+int forEachCompactRBTree(CompactRBTree *tree, forEachFunc func, void *args);
+
+/**
+ * free all memory of the data structure.
+ * @param tree: the tree to free.
+ */
+void freeCompactRBTree(CompactRBTree *tree);
+
+#endif //RBTREE_COMPACTRBTREE_H
@@ -0,0 +1,414 @@
+/**
+* @file PersistentRBTree.c
+* @version 1.0
+*
+* @brief A persistent Red Black Tree, whose old versions stay readable while it is changed.
+*
+* @section DESCRIPTION
+* Items are added by recursion from the root, so no parent links are needed: the place of the new
+* item is searched for on the way down, and every node on the path is copied and rebalanced on the
+* way back up, so an item that is already in the tree costs no allocation. The copies are new to
+* this version, so the rebalancing may change them, while the subtrees they share with older
+* versions are never touched.
+*/
+
+// ------------------------------ includes ------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include "PersistentRBTree.h"
+
+// -------------------------- const definitions -------------------------
+
+// The start size of a tree
+#define START_SIZE (0)
+
+// The error massage that is to be printed if an error occurred when using malloc
+#define ERR_MALLOC "Memory allocation failed\n"
+
+// Stands for success or failure of a function
+#define FAILURE (0)
+#define SUCCESS (1)
+
+// Change a count of references, so that threads that release versions at once agree on which of
+// them frees a node
+#ifdef PERSISTENT_C11_ATOMICS
+#define INIT_REFS(count, value) atomic_init(count, value)
+#define ADD_REF(count) atomic_fetch_add_explicit(count, 1, memory_order_relaxed)
+#define DROP_REF(count) (atomic_fetch_sub_explicit(count, 1, memory_order_acq_rel) == 1)
+#else
+#define INIT_REFS(count, value) (*(count) = (value))
+#define ADD_REF(count) __sync_fetch_and_add(count, 1)
+#define DROP_REF(count) (__sync_fetch_and_sub(count, 1) == 1)
+#endif
+
+// ------------------------------ functions -----------------------------
+
+/**
+ * constructs a new PersistentRBTree with the given CompareFunc.
+ * @param compFunc: a function two compare two variables.
+ * @param freeFunc: a function to free the items of the tree (may be NULL). an item is freed when
+ * no version of the tree holds it anymore.
+ * @return: the new tree, or NULL on failure.
+ */
+PersistentRBTree *newPersistentRBTree(CompareFunc compFunc, FreeFunc freeFunc)
+{
+    PersistentRBTree *newTree = (PersistentRBTree *) malloc(sizeof(PersistentRBTree));
+    if (newTree == NULL)
+    {
+        fprintf(stderr, "%s", ERR_MALLOC);
+        return NULL;
+    }
+    newTree->root = NULL;
+    newTree->compFunc = compFunc;
+    newTree->freeFunc = freeFunc;
+    newTree->size = START_SIZE;
+    return newTree;
+}
+
+/**
+ * @brief drops a reference to the given node, and frees it (with what only it uses) if it was the
+ * last one
+ * @param freeFunc the function to free the items with
+ * @param node the node to release (may be NULL)
+ */
+void releasePersistentNode(FreeFunc freeFunc, PersistentNode *node)
+{
+    if (node == NULL || !DROP_REF(&node->refCount))
+    {
+        return;
+    }
+    releasePersistentNode(freeFunc, node->left);
+    releasePersistentNode(freeFunc, node->right);
+    if (node->itemRefs != NULL && DROP_REF(node->itemRefs))
+    {
+        freeFunc(node->data);
+        free(node->itemRefs);
+    }
+    free(node);
+}
+
+/**
+ * @brief allocates a new red node with no children, that only its parent links to
+ * @param data the item of the node
+ * @param itemRefs the count of the nodes that hold the item (may be NULL), which the new node
+ * takes one of
+ * @return the new node, or NULL if the allocation failed
+ */
+PersistentNode *newPersistentNode(void *data, RefCount *itemRefs)
+{
+    PersistentNode *newNode = (PersistentNode *) malloc(sizeof(PersistentNode));
+    if (newNode == NULL)
+    {
+        fprintf(stderr, "%s", ERR_MALLOC);
+        return NULL;
+    }
+    newNode->left = NULL;
+    newNode->right = NULL;
+    newNode->data = data;
+    newNode->itemRefs = itemRefs;
+    INIT_REFS(&newNode->refCount, 1);
+    newNode->color = RED;
+    return newNode;
+}
+
+/**
+ * @brief copies a node that is on the path to a new item. the copy shares the child that is off
+ * the path with the node, and has no child on the path yet.
+ * @param node the node to copy
+ * @param goesLeft other than 0 if the path goes on to the left child of the node
+ * @return the copy, or NULL if the allocation failed
+ */
+PersistentNode *copyPathNode(PersistentNode *node, int goesLeft)
+{
+    PersistentNode *copy = newPersistentNode(node->data, node->itemRefs);
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+    copy->color = node->color;
+    if (node->itemRefs != NULL)
+    {
+        ADD_REF(node->itemRefs);
+    }
+    PersistentNode *shared = goesLeft ? node->right : node->left;
+    if (shared != NULL)
+    {
+        ADD_REF(&shared->refCount);
+    }
+    if (goesLeft)
+    {
+        copy->right = shared;
+    }
+    else
+    {
+        copy->left = shared;
+    }
+    return copy;
+}
+
+/**
+ * @brief fixes a black node that has a red child with a red child, by making the three of them a
+ * red node with two black children. the three nodes are on the path to the new item, so they are
+ * copies that no other version uses yet.
+ * @param node the node to fix
+ * @return the root of the fixed subtree (the node itself if there was nothing to fix)
+ */
+PersistentNode *balancePersistentNode(PersistentNode *node)
+{
+    if (node->color != BLACK)
+    {
+        return node;
+    }
+    PersistentNode *smallest, *middle, *greatest;
+    PersistentNode *first, *second, *third, *fourth;
+    PersistentNode *left = node->left;
+    PersistentNode *right = node->right;
+    if (left != NULL && left->color == RED && left->left != NULL && left->left->color == RED)
+    {
+        smallest = left->left;
+        middle = left;
+        greatest = node;
+        first = smallest->left;
+        second = smallest->right;
+        third = middle->right;
+        fourth = greatest->right;
+    }
+    else if (left != NULL && left->color == RED && left->right != NULL
+             && left->right->color == RED)
+    {
+        smallest = left;
+        middle = left->right;
+        greatest = node;
+        first = smallest->left;
+        second = middle->left;
+        third = middle->right;
+        fourth = greatest->right;
+    }
+    else if (right != NULL && right->color == RED && right->left != NULL
+             && right->left->color == RED)
+    {
+        smallest = node;
+        middle = right->left;
+        greatest = right;
+        first = smallest->left;
+        second = middle->left;
+        third = middle->right;
+        fourth = greatest->right;
+    }
+    else if (right != NULL && right->color == RED && right->right != NULL
+             && right->right->color == RED)
+    {
+        smallest = node;
+        middle = right;
+        greatest = right->right;
+        first = smallest->left;
+        second = middle->left;
+        third = greatest->left;
+        fourth = greatest->right;
+    }
+    else
+    {
+        return node;
+    }
+    smallest->left = first;
+    smallest->right = second;
+    smallest->color = BLACK;
+    greatest->left = third;
+    greatest->right = fourth;
+    greatest->color = BLACK;
+    middle->left = smallest;
+    middle->right = greatest;
+    middle->color = RED;
+    return middle;
+}
+
+/**
+ * @brief adds an item to a subtree by recursion, copying the nodes on the way back up from it
+ * @param tree the tree the subtree is in
+ * @param node the root of the subtree (may be NULL), which is left as it was
+ * @param data the item to add
+ * @param added the node of the new item is put here (NULL if none was made)
+ * @return the root of the new version of the subtree, or NULL if the item is already in the
+ * subtree or an allocation failed (in which case nothing was changed)
+ */
+PersistentNode *insertPersistentNode(PersistentRBTree *tree, PersistentNode *node, void *data,
+                                     PersistentNode **added)
+{
+    if (node == NULL)
+    {
+        *added = newPersistentNode(data, NULL);
+        return *added;
+    }
+    int comp = tree->compFunc(data, node->data);
+    if (comp == 0)
+    {
+        *added = NULL;
+        return NULL;
+    }
+    int goesLeft = comp < 0;
+    PersistentNode *child = insertPersistentNode(tree, goesLeft ? node->left : node->right, data,
+                                                 added);
+    if (child == NULL)
+    {
+        return NULL;
+    }
+    PersistentNode *copy = copyPathNode(node, goesLeft);
+    if (copy == NULL)
+    {
+        // the new node holds no count of its item yet, so the item is not freed with it
+        releasePersistentNode(tree->freeFunc, child);
+        *added = NULL;
+        return NULL;
+    }
+    if (goesLeft)
+    {
+        copy->left = child;
+    }
+    else
+    {
+        copy->right = child;
+    }
+    return balancePersistentNode(copy);
+}
+
+/**
+ * check whether the tree contains this item.
+ * @param tree: the tree (or snapshot) to search in.
+ * @param data: item to check.
+ * @return: 0 if the item is not in the tree, other if it is.
+ */
+int containsPersistentRBTree(PersistentRBTree *tree, void *data)
+{
+    if (tree == NULL || data == NULL)
+    {
+        return FAILURE;
+    }
+    const PersistentNode *curNode = tree->root;
+    while (curNode != NULL)
+    {
+        int comp = tree->compFunc(curNode->data, data);
+        if (comp == 0)
+        {
+            return SUCCESS;
+        }
+        curNode = comp > 0 ? curNode->left : curNode->right;
+    }
+    return FAILURE;
+}
+
+/**
+ * add an item to the tree. searches the tree once, copies the O(log n) nodes on the path to the
+ * item, and leaves the snapshots of the tree as they were.
+ * @param tree: the tree to add an item to.
+ * @param data: item to add to the tree.
+ * @return: 0 on failure, other on success. (if the item is already in the tree - failure).
+ */
+int addToPersistentRBTree(PersistentRBTree *tree, void *data)
+{
+    if (tree == NULL || data == NULL)
+    {
+        return FAILURE;
+    }
+    PersistentNode *added;
+    PersistentNode *newRoot = insertPersistentNode(tree, tree->root, data, &added);
+    if (newRoot == NULL)
+    {
+        return FAILURE;
+    }
+    if (tree->freeFunc != NULL)
+    {
+        // the item is counted only once it is known to be new
+        added->itemRefs = (RefCount *) malloc(sizeof(RefCount));
+        if (added->itemRefs == NULL)
+        {
+            fprintf(stderr, "%s", ERR_MALLOC);
+            releasePersistentNode(tree->freeFunc, newRoot);
+            return FAILURE;
+        }
+        INIT_REFS(added->itemRefs, 1);
+    }
+    newRoot->color = BLACK;
+    // the old version of the tree lives on only in its snapshots
+    releasePersistentNode(tree->freeFunc, tree->root);
+    tree->root = newRoot;
+    tree->size += 1;
+    return SUCCESS;
+}
+
+/**
+ * @brief goes over a subtree from the smallest node to the biggest one by recursion
+ * @param node the root of the subtree
+ * @param func the function to invoke on the items
+ * @param args optional argument that the function might use
+ * @return: 0 on failure in any step, other on success.
+ */
+int forEachPersistentNode(const PersistentNode *node, forEachFunc func, void *args)
+{
+    if (node == NULL)
+    {
+        return SUCCESS;
+    }
+    if (forEachPersistentNode(node->left, func, args) == FAILURE || func(node->data, args) == 0)
+    {
+        return FAILURE;
+    }
+    return forEachPersistentNode(node->right, func, args);
+}
+
+/**
+ * Activate a function on each item of the tree. the order is an ascending order. if one of the activations of the
+ * function returns 0, the process stops.
+ * @param tree: the tree (or snapshot) with all the items.
+ * @param func: the function to activate on all items.
+ * @param args: more optional arguments to the function (may be null if the given function support it).
+ * @return: 0 on failure, other on success.
+ */
+int forEachPersistentRBTree(PersistentRBTree *tree, forEachFunc func, void *args)
+{
+    if (tree == NULL || func == NULL)
+    {
+        return FAILURE;
+    }
+    return forEachPersistentNode(tree->root, func, args);
+}
+
+/**
+ * take a snapshot of the tree: a version that keeps the items the tree has now, however the tree
+ * is changed later. takes O(1). it is taken by the thread that changes the tree, and can then be
+ * read by any thread.
+ * @param tree: the tree to take a snapshot of.
+ * @return: the snapshot, which is freed with freePersistentRBTree. NULL on failure.
+ */
+PersistentRBTree *snapshotPersistentRBTree(PersistentRBTree *tree)
+{
+    if (tree == NULL)
+    {
+        return NULL;
+    }
+    PersistentRBTree *snapshot = newPersistentRBTree(tree->compFunc, tree->freeFunc);
+    if (snapshot == NULL)
+    {
+        return NULL;
+    }
+    if (tree->root != NULL)
+    {
+        ADD_REF(&tree->root->refCount);
+    }
+    snapshot->root = tree->root;
+    snapshot->size = tree->size;
+    return snapshot;
+}
+
+/**
+ * free a version of the tree, with the nodes and the items that no other version uses. may be
+ * called by any thread, for a version that no other thread reads.
+ * @param tree: the tree (or snapshot) to free.
+ */
+void freePersistentRBTree(PersistentRBTree *tree)
+{
+    if (tree != NULL)
+    {
+        releasePersistentNode(tree->freeFunc, tree->root);
+        free(tree);
+    }
+}
@@ -0,0 +1,113 @@
+/**
+* @file PersistentRBTree.h
+* @version 1.0
+*
+* @brief A persistent Red Black Tree, whose old versions stay readable while it is changed.
+*
+* @section DESCRIPTION
+* The nodes have no parent links, so a subtree can be shared by many versions of the tree. Adding
+* an item copies only the nodes on the path from the root down to it, and a snapshot of the tree
+* is a new reference to its root, taken in O(1). Every node counts the references to it, and it is
+* freed (with its item, once no node holds the item anymore) when the last version that uses it is
+* freed.
+*/
+
+#ifndef RBTREE_PERSISTENTRBTREE_H
+#define RBTREE_PERSISTENTRBTREE_H
+
+#include "RBTree.h"
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+
+// Tells that the counts of references are C11 atomics
+#define PERSISTENT_C11_ATOMICS
+
+// a count of references, that threads can change at once
+typedef atomic_int RefCount;
+#else
+// a count of references, that is changed with the atomic builtins of the compiler
+typedef int RefCount;
+#endif
+
+/*
+ * a node of the persistent tree. once a node is in a version of the tree, it is never changed.
+ * refCount: the amount of nodes and versions that link to this node.
+ * itemRefs: the amount of nodes that hold the item of this node (shared by all of them). NULL
+ * when the tree does not free its items.
+ */
+typedef struct PersistentNode
+{
+	struct PersistentNode *left, *right;
+	void *data;
+	RefCount *itemRefs;
+	RefCount refCount;
+	Color color;
+} PersistentNode;
+
+/**
+ * represents a version of the persistent tree.
+ * a version is changed only by the thread that adds items to it. a snapshot of it can be read by
+ * any thread, while the version itself keeps changing.
+ */
+typedef struct PersistentRBTree
+{
+	PersistentNode *root;
+	CompareFunc compFunc;
+	FreeFunc freeFunc;
+	int size;
+} PersistentRBTree;
+
+/**
+ * constructs a new PersistentRBTree with the given CompareFunc.
+ * @param compFunc: a function two compare two variables.
+ * @param freeFunc: a function to free the items of the tree (may be NULL). an item is freed when
+ * no version of the tree holds it anymore.
+ * @return: the new tree, or NULL on failure.
+ */
+PersistentRBTree *newPersistentRBTree(CompareFunc compFunc, FreeFunc freeFunc);
+
+/**
+ * add an item to the tree. copies the O(log n) nodes on the path to the item, and leaves the
+ * snapshots of the tree as they were.
+ * @param tree: the tree to add an item to.
+ * @param data: item to add to the tree.
+ * @return: 0 on failure, other on success. (if the item is already in the tree - failure).
+ */
+int addToPersistentRBTree(PersistentRBTree *tree, void *data);
+
+/**
+ * check whether the tree contains this item.
+ * @param tree: the tree (or snapshot) to search in.
+ * @param data: item to check.
+ * @return: 0 if the item is not in the tree, other if it is.
+ */
+int containsPersistentRBTree(PersistentRBTree *tree, void *data);
+
+/**
+ * Activate a function on each item of the tree. the order is an ascending order. if one of the activations of the
+ * function returns 0, the process stops.
+ * @param tree: the tree (or snapshot) with all the items.
+ * @param func: the function to activate on all items.
+ * @param args: more optional arguments to the function (may be null if the given function support it).
+ * @return: 0 on failure, other on success.
+ */
+int forEachPersistentRBTree(PersistentRBTree *tree, forEachFunc func, void *args);
+
+/**
+ * take a snapshot of the tree: a version that keeps the items the tree has now, however the tree
+ * is changed later. takes O(1). it is taken by the thread that changes the tree, and can then be
+ * read by any thread.
+ * @param tree: the tree to take a snapshot of.
+ * @return: the snapshot, which is freed with freePersistentRBTree. NULL on failure.
+ */
+PersistentRBTree *snapshotPersistentRBTree(PersistentRBTree *tree);
+
+/**
+ * free a version of the tree, with the nodes and the items that no other version uses. may be
+ * called by any thread, for a version that no other thread reads.
+ * @param tree: the tree (or snapshot) to free.
+ */
+void freePersistentRBTree(PersistentRBTree *tree);
+
+#endif //RBTREE_PERSISTENTRBTREE_H
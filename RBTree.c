@@ -15,6 +15,11 @@
 // ------------------------------ includes ------------------------------
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#ifndef RBTREE_NO_THREADS
+#include <pthread.h>
+#endif
 #include "RBTree.h"
 
 // -------------------------- const definitions -------------------------
@@ -33,6 +38,86 @@
 #define FAILURE (0)
 #define SUCCESS (1)
 
+// The alignment of the room that comes after a node
+#define TRAILER_ALIGNMENT (sizeof(double) > sizeof(void *) ? sizeof(double) : sizeof(void *))
+
+// The biggest aggregate a range query keeps on the stack instead of allocating room for it
+#define STACK_AGGREGATE_SIZE (64)
+
+// The operations of the set algebra of two trees
+#define UNION_OPERATION (0)
+#define INTERSECT_OPERATION (1)
+#define DIFFERENCE_OPERATION (2)
+
+// The lowest black height of a subtree whose set operation is handed to a thread of its own (so
+// it has at least 2^10 - 1 nodes)
+#define MIN_PARALLEL_HEIGHT (10)
+
+// ------------------------------ structs -------------------------------
+
+/**
+ * the links a node of a threaded tree has to its neighbours in the order of the tree. they are
+ * kept right after the node.
+ */
+typedef struct NodeLinks
+{
+	Node *prev, *next;
+} NodeLinks;
+
+/**
+ * the subtrees that a set operation took out of its result, to be released once it is done.
+ * they are linked by the parent links of their roots.
+ */
+typedef struct DroppedNodes
+{
+	Node *first, *last;
+} DroppedNodes;
+
+/**
+ * a part of a set operation, that runs in a thread of its own.
+ * scratch: a copy of the tree the operation is done in, whose root the thread may change.
+ */
+typedef struct SetTask
+{
+	RBTree scratch;
+	int operation;
+	Node *tree, *other;
+	int treeHeight, otherHeight;
+	int forks;
+	DroppedNodes dropped;
+	Node *result;
+	int resultHeight;
+} SetTask;
+
+/**
+ * a part of cloning a tree, that runs in a thread of its own.
+ * scratch: a copy of the new tree with a slab and an arena of its own, that the thread allocates
+ * its nodes from.
+ */
+typedef struct CloneTask
+{
+	RBTree scratch;
+	CopyFunc copyFunc;
+	Node *node;
+	int height;
+	int forks;
+	size_t share;
+	Node *result;
+	int isCloned;
+} CloneTask;
+
+/**
+ * the item with the greatest score in the subtree of a node, in a tree with a maxScoreFunc. it is
+ * kept after the node (and after its links, in a threaded tree).
+ * score: the score of the item of the node itself, so it is taken only once.
+ */
+typedef struct MaxScore
+{
+	double score;
+	double maxScore;
+	void *maxData;
+} MaxScore;
+
 // ------------------------------ functions -----------------------------
 
 /**
@@ -41,7 +126,63 @@
  */
 RBTree *newRBTree(CompareFunc compFunc, FreeFunc freeFunc)
 {
-    RBTree *newTree = (RBTree *) malloc(sizeof(RBTree));
+    return newRBTreeWithOptions(compFunc, freeFunc, NULL);
+}
+
+/**
+ * @brief rounds the given size up, so the room that comes after it in a node stays aligned
+ * @param size the size of a value that is kept after a node
+ * @return the room the value takes
+ */
+size_t trailerRoom(size_t size)
+{
+    return (size + TRAILER_ALIGNMENT - 1) / TRAILER_ALIGNMENT * TRAILER_ALIGNMENT;
+}
+
+/**
+ * constructs a new RBTree with the given CompareFunc and settings.
+ * @param compFunc: a function two compare two variables.
+ * @param freeFunc: a function to free the items of the tree (may be NULL).
+ * @param options: the settings of the tree (may be NULL for the default ones).
+ * @return: the new tree, or NULL on failure (or if the settings do not fit together).
+ */
+RBTree *newRBTreeWithOptions(CompareFunc compFunc, FreeFunc freeFunc, const RBTreeOptions *options)
+{
+    const RBTreeOptions defaultOptions = {0};
+    if (options == NULL)
+    {
+        options = &defaultOptions;
+    }
+    if (options->inlineKeySize != 0 && (options->inlineCopyFunc == NULL || options->isIntrusive))
+    {
+        return NULL;
+    }
+    if (options->arenaCopyFunc != NULL && (options->inlineKeySize != 0 || options->isIntrusive))
+    {
+        return NULL;
+    }
+    if ((options->isThreaded || options->maxScoreFunc != NULL || options->aggregateSize != 0
+         || options->isMultiset || options->isMap) && options->isIntrusive)
+    {
+        return NULL;
+    }
+    if (options->isMap && options->isMultiset)
+    {
+        return NULL;
+    }
+    if (options->aggregateSize != 0
+        && (options->aggregateItemFunc == NULL || options->aggregateCombineFunc == NULL))
+    {
+        return NULL;
+    }
+    const Allocator *allocator = options->allocator;
+    if (allocator != NULL && (allocator->alloc == NULL || allocator->free == NULL))
+    {
+        return NULL;
+    }
+    RBTree *newTree = (RBTree *) (allocator != NULL
+                                  ? allocator->alloc(sizeof(RBTree), allocator->context)
+                                  : malloc(sizeof(RBTree)));
     if (newTree == NULL)
     {
         fprintf(stderr, "%s", ERR_MALLOC);
@@ -51,24 +192,206 @@ RBTree *newRBTree(CompareFunc compFunc, FreeFunc freeFunc)
     newTree->compFunc = compFunc;
     newTree->freeFunc = freeFunc;
     newTree->size = START_SIZE;
+    if (allocator != NULL)
+    {
+        newTree->allocator = *allocator;
+        allocator = &newTree->allocator;
+    }
+    else
+    {
+        newTree->allocator = (Allocator) {NULL, NULL, NULL, NULL};
+    }
+    newTree->isThreaded = options->isThreaded;
+    newTree->linksOffset = sizeof(Node);
+    newTree->maxScoreFunc = options->maxScoreFunc;
+    newTree->maxScoreOffset = newTree->linksOffset + (newTree->isThreaded ? sizeof(NodeLinks) : 0);
+    newTree->aggregateSize = options->aggregateSize;
+    newTree->aggregateItemFunc = options->aggregateItemFunc;
+    newTree->aggregateCombineFunc = options->aggregateCombineFunc;
+    newTree->aggregateOffset = newTree->maxScoreOffset
+                               + (newTree->maxScoreFunc != NULL ? sizeof(MaxScore) : 0);
+    newTree->isMultiset = options->isMultiset;
+    newTree->countOffset = newTree->aggregateOffset + trailerRoom(newTree->aggregateSize);
+    newTree->isMap = options->isMap;
+    newTree->valueFreeFunc = options->valueFreeFunc;
+    newTree->valueOffset = newTree->countOffset
+                           + (newTree->isMultiset ? trailerRoom(sizeof(int)) : 0);
+    newTree->inlineKeyOffset = newTree->valueOffset
+                               + (newTree->isMap ? trailerRoom(sizeof(void *)) : 0);
+    newTree->first = NULL;
+    newTree->last = NULL;
+    newTree->nextSharing = newTree;
+    initSlab(&newTree->nodeSlab, newTree->inlineKeyOffset + options->inlineKeySize,
+             options->useHugePages, allocator);
+    newTree->isIntrusive = options->isIntrusive;
+    newTree->nodeOffset = options->nodeOffset;
+    newTree->inlineKeySize = options->inlineKeySize;
+    newTree->inlineCopyFunc = options->inlineCopyFunc;
+    initArena(&newTree->keyArena, allocator);
+    newTree->arenaCopyFunc = options->arenaCopyFunc;
+    newTree->sizeFunc = options->sizeFunc;
+    newTree->dataBytes = 0;
+    newTree->hasOrderStatistics = options->hasOrderStatistics;
+    newTree->isAugmented = newTree->hasOrderStatistics || newTree->maxScoreFunc != NULL
+                           || newTree->aggregateSize != 0;
     return newTree;
 }
 
 /**
- * @brief checks whether the given node is a right child according to the given compFunc
- * @param compFunc the compare function to check with
+ * @brief returns the amount of items in the subtree of the given node, in a tree with order
+ * statistics
+ * @param node the root of the subtree (may be NULL)
+ * @return the amount of items
+ */
+int subtreeSizeOf(const Node *node)
+{
+    return node == NULL ? 0 : node->subtreeSize;
+}
+
+/**
+ * @brief returns the scores the given node keeps, in a tree with a maxScoreFunc
+ * @param tree the tree of the node
+ * @param node the node to get the scores of
+ * @return the scores
+ */
+MaxScore *maxScoreOf(const RBTree *tree, Node *node)
+{
+    return (MaxScore *) ((char *) node + tree->maxScoreOffset);
+}
+
+/**
+ * @brief returns the aggregate of the subtree of the given node, in a tree that keeps aggregates
+ * @param tree the tree of the node
+ * @param node the root of the subtree
+ * @return the aggregate
+ */
+void *aggregateOf(const RBTree *tree, const Node *node)
+{
+    return (void *) ((const char *) node + tree->aggregateOffset);
+}
+
+/**
+ * @brief returns the amount of times the item of the given node was added, in a multiset
+ * @param tree the tree of the node
+ * @param node the node to get the count of
+ * @return the count
+ */
+int *countOf(const RBTree *tree, const Node *node)
+{
+    return (int *) ((const char *) node + tree->countOffset);
+}
+
+/**
+ * @brief returns the place of the value of the given node, in a map
+ * @param tree the tree of the node
+ * @param node the node to get the value of
+ * @return the place of the value
+ */
+void **valueOf(const RBTree *tree, const Node *node)
+{
+    return (void **) ((const char *) node + tree->valueOffset);
+}
+
+/**
+ * @brief frees the value of the given node with the valueFreeFunc of the tree, in a map
+ * @param tree the tree of the node
+ * @param node the node whose value to free
+ */
+void freeValueOf(RBTree *tree, Node *node)
+{
+    if (tree->isMap && tree->valueFreeFunc != NULL && *valueOf(tree, node) != NULL)
+    {
+        tree->valueFreeFunc(*valueOf(tree, node));
+    }
+}
+
+/**
+ * @brief tells how many times the item of the given node is in the tree
+ * @param tree the tree of the node
+ * @param node the node to check
+ * @return the count of the item in a multiset, and 1 otherwise
+ */
+int occurrencesOf(const RBTree *tree, const Node *node)
+{
+    return tree->isMultiset ? *countOf(tree, node) : 1;
+}
+
+/**
+ * @brief recomputes the values the given node keeps about its subtree, out of its children
+ * @param tree the tree of the node
+ * @param node the node to recompute
+ */
+void updateNode(RBTree *tree, Node *node)
+{
+    if (tree->hasOrderStatistics)
+    {
+        node->subtreeSize = 1 + subtreeSizeOf(node->left) + subtreeSizeOf(node->right);
+    }
+    if (tree->maxScoreFunc != NULL)
+    {
+        // on a tie, the item that comes first in the order of the tree wins
+        MaxScore *best = maxScoreOf(tree, node);
+        best->maxScore = best->score;
+        best->maxData = node->data;
+        if (node->left != NULL && maxScoreOf(tree, node->left)->maxScore >= best->maxScore)
+        {
+            best->maxScore = maxScoreOf(tree, node->left)->maxScore;
+            best->maxData = maxScoreOf(tree, node->left)->maxData;
+        }
+        if (node->right != NULL && maxScoreOf(tree, node->right)->maxScore > best->maxScore)
+        {
+            best->maxScore = maxScoreOf(tree, node->right)->maxScore;
+            best->maxData = maxScoreOf(tree, node->right)->maxData;
+        }
+    }
+    if (tree->aggregateSize != 0)
+    {
+        void *aggregate = aggregateOf(tree, node);
+        tree->aggregateItemFunc(aggregate, node->data);
+        if (node->left != NULL)
+        {
+            tree->aggregateCombineFunc(aggregate, aggregateOf(tree, node->left), aggregate);
+        }
+        if (node->right != NULL)
+        {
+            tree->aggregateCombineFunc(aggregate, aggregate, aggregateOf(tree, node->right));
+        }
+    }
+}
+
+/**
+ * @brief recomputes the values the nodes keep about their subtrees, from the given node up to
+ * the root
+ * @param tree the tree of the nodes
+ * @param node the lowest node whose subtree was changed (may be NULL)
+ */
+void updatePath(RBTree *tree, Node *node)
+{
+    if (!tree->isAugmented)
+    {
+        return;
+    }
+    while (node != NULL)
+    {
+        updateNode(tree, node);
+        node = node->parent;
+    }
+}
+
+/**
+ * @brief checks whether the given node is a right child of its parent
  * @param toCheck the Node to check what side it is
  * @return 1 if it is a right child, 0 if it doesn't have a parent, -1 if it isn't those two- so
  * it is a left child
  */
-int isRightChild(CompareFunc compFunc, Node *toCheck)
+int isRightChild(Node *toCheck)
 {
     Node *parent = toCheck->parent;
     if (parent == NULL)
     {
         return 0;
     }
-    if (parent->right != NULL && compFunc(parent->right->data, toCheck->data) == 0)
+    if (parent->right == toCheck)
     {
         return RIGHT_CHILD;
     }
@@ -78,12 +401,11 @@ int isRightChild(CompareFunc compFunc, Node *toCheck)
 /**
  * @brief finds and returns the uncle of the given Node
  * @param toFind the node to find it's uncle
- * @param tree the tree we work in
  * @return the uncle of the given node
  */
-Node *findUncle(Node *toFind, RBTree *tree)
+Node *findUncle(Node *toFind)
 {
-    if (isRightChild(tree->compFunc, toFind->parent) == RIGHT_CHILD)
+    if (isRightChild(toFind->parent) == RIGHT_CHILD)
     {
         return toFind->parent->parent->left;
     }
@@ -95,8 +417,9 @@ Node *findUncle(Node *toFind, RBTree *tree)
 * @param parent the parent of the added node
 * @param parent the parent of the added node
 * @param grandparent the grandparent of the added node
+* @param tree the tree to do the change in
 */
-void leftRightSwitch(Node *newNode, Node *parent, Node *grandparent)
+void leftRightSwitch(Node *newNode, Node *parent, Node *grandparent, RBTree *tree)
 {
     parent->right = newNode->left;
     if (newNode->left != NULL)
@@ -107,6 +430,8 @@ void leftRightSwitch(Node *newNode, Node *parent, Node *grandparent)
     parent->parent = newNode;
     newNode->parent = grandparent;
     grandparent->left = newNode;
+    updateNode(tree, parent);
+    updateNode(tree, newNode);
 }
 
 /**
@@ -124,7 +449,7 @@ void leftLeftSwitch(Node *parent, Node *grandparent, RBTree *tree)
     }
     else
     {
-        if (isRightChild(tree->compFunc, grandparent) == RIGHT_CHILD)
+        if (isRightChild(grandparent) == RIGHT_CHILD)
         {
             grandparent->parent->right = parent;
         }
@@ -140,6 +465,8 @@ void leftLeftSwitch(Node *parent, Node *grandparent, RBTree *tree)
     }
     parent->right = grandparent;
     grandparent->parent = parent;
+    updateNode(tree, grandparent);
+    updateNode(tree, parent);
 }
 
 /**
@@ -147,8 +474,9 @@ void leftLeftSwitch(Node *parent, Node *grandparent, RBTree *tree)
  * @param parent the parent of the added node
  * @param parent the parent of the added node
  * @param grandparent the grandparent of the added node
+ * @param tree the tree to do the change in
  */
-void rightLeftSwitch(Node *newNode, Node *parent, Node *grandparent)
+void rightLeftSwitch(Node *newNode, Node *parent, Node *grandparent, RBTree *tree)
 {
     parent->left = newNode->right;
     if (newNode->right != NULL)
@@ -159,6 +487,8 @@ void rightLeftSwitch(Node *newNode, Node *parent, Node *grandparent)
     parent->parent = newNode;
     grandparent->right = newNode;
     newNode->parent = grandparent;
+    updateNode(tree, parent);
+    updateNode(tree, newNode);
 }
 
 /**
@@ -176,7 +506,7 @@ void rightRightSwitch(Node *parent, Node *grandparent, RBTree *tree)
     }
     else
     {
-        if (isRightChild(tree->compFunc, grandparent) == RIGHT_CHILD)
+        if (isRightChild(grandparent) == RIGHT_CHILD)
         {
             grandparent->parent->right = parent;
         }
@@ -192,6 +522,8 @@ void rightRightSwitch(Node *parent, Node *grandparent, RBTree *tree)
     }
     parent->left = grandparent;
     grandparent->parent = parent;
+    updateNode(tree, grandparent);
+    updateNode(tree, parent);
 }
 
 /**
@@ -203,13 +535,13 @@ void rightRightSwitch(Node *parent, Node *grandparent, RBTree *tree)
  */
 void modifyRedBlack(Node *newNode, Node *parent, Node *grandparent, RBTree *tree)
 {
-    int nChildType = isRightChild(tree->compFunc, newNode);
-    int pChildType = isRightChild(tree->compFunc, parent);
+    int nChildType = isRightChild(newNode);
+    int pChildType = isRightChild(parent);
     if (pChildType == LEFT_CHILD)
     {
         if (nChildType == RIGHT_CHILD)
         {
-            leftRightSwitch(newNode, parent, grandparent);
+            leftRightSwitch(newNode, parent, grandparent, tree);
             parent = newNode;
         }
         leftLeftSwitch(parent, grandparent, tree);
@@ -218,7 +550,7 @@ void modifyRedBlack(Node *newNode, Node *parent, Node *grandparent, RBTree *tree
     {
         if (nChildType == LEFT_CHILD)
         {
-            rightLeftSwitch(newNode, parent, grandparent);
+            rightLeftSwitch(newNode, parent, grandparent, tree);
             parent = newNode;
         }
         rightRightSwitch(parent, grandparent, tree);
@@ -246,7 +578,7 @@ void modifyNode(Node *toModify, RBTree *tree)
     {
         return;
     }
-    Node *uncle = findUncle(toModify, tree); // must be (real or NULL) because parent is red
+    Node *uncle = findUncle(toModify); // must be (real or NULL) because parent is red
     Node *grandparent = parent->parent;
     // parent is red and uncle is red
     if (uncle != NULL)
@@ -265,189 +597,2966 @@ void modifyNode(Node *toModify, RBTree *tree)
 }
 
 /**
- * @brief adds the new Node given to the correct place in relative to the given compare to Node
- * @param compToNode a not NULL Node to put the Node that we want to add in relative to
- * @param addNode the new Node to add to the tree
- * @return 1 if was added well, 0 if didn't (there was already another node with the same data)
+ * @brief finds the place where a Node with the given data should be added
+ * @param compToNode a not NULL Node to start the search from
+ * @param data the data of the Node that we want to add
+ * @param compFunc the function to compare the data with
+ * @param compare the result of comparing the data with the returned Node is put here (0 if the
+ * data is already in the tree)
+ * @return the Node that should become the parent of the new Node, or the Node that already has
+ * the same data
  */
-int addNewNode(Node *compToNode, Node *addNode, CompareFunc compFunc)
+Node *findAddPlace(Node *compToNode, const void *data, CompareFunc compFunc, int *compare)
 {
-    int compare = compFunc(addNode->data, compToNode->data);
-    if (compare == 0)
+    while (1)
     {
-        return FAILURE;
+        *compare = compFunc(data, compToNode->data);
+        Node *next = *compare < 0 ? compToNode->left : compToNode->right;
+        if (*compare == 0 || next == NULL)
+        {
+            return compToNode;
+        }
+        compToNode = next;
+    }
+}
+
+/**
+ * @brief goes on with the search of findAddPlace from a Node that the data was already compared
+ * with, without comparing it again
+ * @param compared the Node the data was compared with
+ * @param data the data of the Node that we want to add
+ * @param compFunc the function to compare the data with
+ * @param compare the result of comparing the data with compared. the result of comparing it with
+ * the returned Node is put here
+ * @return the Node that should become the parent of the new Node, or the Node that already has
+ * the same data
+ */
+Node *findAddPlaceBelow(Node *compared, const void *data, CompareFunc compFunc, int *compare)
+{
+    Node *next = *compare < 0 ? compared->left : compared->right;
+    if (*compare == 0 || next == NULL)
+    {
+        return compared;
     }
+    return findAddPlace(next, data, compFunc, compare);
+}
+
+/**
+ * @brief adds the new Node given as a child of the given parent
+ * @param parent the Node that was found by findAddPlace
+ * @param addNode the new Node to add to the tree
+ * @param compare the result of comparing the new Node with the parent (not 0)
+ */
+void addNewNode(Node *parent, Node *addNode, int compare)
+{
     if (compare < 0)
     {
-        if (compToNode->left == NULL)
-        {
-            compToNode->left = addNode;
-            addNode->parent = compToNode;
-            return SUCCESS;
-        }
-        return addNewNode(compToNode->left, addNode, compFunc);
+        parent->left = addNode;
     }
-    // else: compare > 0
-    if (compToNode->right == NULL)
+    else
     {
-        compToNode->right = addNode;
-        addNode->parent = compToNode;
-        return SUCCESS;
+        parent->right = addNode;
+    }
+    addNode->parent = parent;
+}
+
+/**
+ * @brief returns the room for an item that comes after the given node, in a tree that keeps its
+ * items inside its nodes
+ * @param tree the tree of the node
+ * @param node the node to get the room of
+ * @return the start of the room
+ */
+void *inlineKeyBuffer(const RBTree *tree, Node *node)
+{
+    return (void *) ((char *) node + tree->inlineKeyOffset);
+}
+
+/**
+ * @brief returns the links of the given node to its neighbours, in a threaded tree
+ * @param tree the tree of the node
+ * @param node the node to get the links of
+ * @return the links
+ */
+NodeLinks *linksOf(const RBTree *tree, Node *node)
+{
+    return (NodeLinks *) ((char *) node + tree->linksOffset);
+}
+
+/**
+ * @brief links the given node between its two neighbours, in a threaded tree
+ * @param tree the tree of the node
+ * @param node the node to link
+ * @param prev the node that comes before it (NULL if it is the first node)
+ * @param next the node that comes after it (NULL if it is the last node)
+ */
+void threadNode(RBTree *tree, Node *node, Node *prev, Node *next)
+{
+    linksOf(tree, node)->prev = prev;
+    linksOf(tree, node)->next = next;
+    if (prev != NULL)
+    {
+        linksOf(tree, prev)->next = node;
+    }
+    else
+    {
+        tree->first = node;
+    }
+    if (next != NULL)
+    {
+        linksOf(tree, next)->prev = node;
+    }
+    else
+    {
+        tree->last = node;
+    }
+}
+
+/**
+ * @brief unlinks the given node from its neighbours, in a threaded tree
+ * @param tree the tree of the node
+ * @param node the node to unlink
+ */
+void unthreadNode(RBTree *tree, Node *node)
+{
+    Node *prev = linksOf(tree, node)->prev;
+    Node *next = linksOf(tree, node)->next;
+    if (prev != NULL)
+    {
+        linksOf(tree, prev)->next = next;
+    }
+    else
+    {
+        tree->first = next;
+    }
+    if (next != NULL)
+    {
+        linksOf(tree, next)->prev = prev;
+    }
+    else
+    {
+        tree->last = prev;
     }
-    return addNewNode(compToNode->right, addNode, compFunc);
 }
 
 /**
- * @brief Allocates a new Node, with no children nor parent, with the data given and red colored
+ * @brief Allocates a new Node from the slab of the tree (or takes the one embedded in the data of
+ * an intrusive tree), with no children nor parent, with the data given and red colored. a tree
+ * that keeps its items inside its nodes or in its arena gets a copy of the data instead.
+ * @param tree the tree the node is made for
  * @param data the data the data of the new node
- * @return a pointer to this Node (should be freed!) or NULL if the allocation didn't work
+ * @return a pointer to this Node (lives until the slab is freed) or NULL if the allocation didn't
+ * work
  */
-Node *makeNewNode(void *data)
+Node *makeNewNode(RBTree *tree, void *data)
 {
-    Node *newNode = (Node *) malloc(sizeof(Node));
+    Node *newNode = tree->isIntrusive ? (Node *) ((char *) data + tree->nodeOffset)
+                                      : (Node *) slabAlloc(&tree->nodeSlab);
     if (newNode == NULL)
     {
         fprintf(stderr, "%s", ERR_MALLOC);
         return NULL;
     }
+    if (tree->inlineKeySize != 0 || tree->arenaCopyFunc != NULL)
+    {
+        data = tree->arenaCopyFunc != NULL
+               ? tree->arenaCopyFunc(data, &tree->keyArena)
+               : tree->inlineCopyFunc(data, inlineKeyBuffer(tree, newNode), tree->inlineKeySize);
+        if (data == NULL)
+        {
+            slabFree(&tree->nodeSlab, newNode);
+            return NULL;
+        }
+    }
     newNode->right = NULL;
     newNode->left = NULL;
     newNode->parent = NULL;
     newNode->data = data;
     newNode->color = RED;
+    newNode->subtreeSize = 1;
+    if (tree->isMultiset)
+    {
+        *countOf(tree, newNode) = 1;
+    }
+    if (tree->isMap)
+    {
+        *valueOf(tree, newNode) = NULL;
+    }
+    if (tree->maxScoreFunc != NULL)
+    {
+        maxScoreOf(tree, newNode)->score = tree->maxScoreFunc(data);
+    }
+    if (tree->maxScoreFunc != NULL || tree->aggregateSize != 0)
+    {
+        updateNode(tree, newNode);
+    }
     return newNode;
 }
 
 /**
- * @brief frees the given node by first freeing it's children by recursion
- * @param node the node to free
- * @param freeFunc the function to free the node with
+ * @brief frees the data of the given node and of all of its children by recursion (with their
+ * values, in a map). the nodes themselves are freed with the slab of the tree, or with the data of
+ * an intrusive tree (so the node must not be touched after its data is freed). data that is kept
+ * inside its node or in the arena of the tree is not freed on its own.
+ * @param tree the tree of the nodes, with the function to free the data with
+ * @param node the node to free its data
  */
-void freeNodes(Node *node, FreeFunc freeFunc)
+void freeNodes(RBTree *tree, Node *node)
 {
     if (node != NULL)
     {
         if (node->left != NULL)
         {
-            freeNodes(node->left, freeFunc);
+            freeNodes(tree, node->left);
         }
         if (node->right != NULL)
         {
-            freeNodes(node->right, freeFunc);
+            freeNodes(tree, node->right);
         }
-        if (node->data != NULL)
+        freeValueOf(tree, node);
+        int isInline = tree->inlineKeySize != 0 && node->data == inlineKeyBuffer(tree, node);
+        if (node->data != NULL && !isInline && tree->freeFunc != NULL
+            && tree->arenaCopyFunc == NULL)
         {
-            freeFunc(node->data);
-            node->data = NULL;
+            tree->freeFunc(node->data);
         }
-        free(node);
     }
 }
 
 /**
- * add an item to the tree
- * @param tree: the tree to add an item to.
- * @param data: item to add to the tree.
- * @return: 0 on failure, other on success. (if the item is already in the tree - failure).
+ * @brief tells the amount of bytes the data of the given node owns outside of the node and of
+ * the arena of the tree, according to the SizeFunc of the tree
+ * @param tree the tree of the node
+ * @param node the node to check
+ * @return the amount of bytes, 0 if the tree has no SizeFunc
  */
-int addToRBTree(RBTree *tree, void *data)
+size_t ownedDataSize(RBTree *tree, Node *node)
 {
-    Node *newNode = makeNewNode(data);
-    if (newNode == NULL)
-    {
-        return FAILURE;
-    }
-    if (tree->root == NULL)
+    if (tree->sizeFunc == NULL || tree->arenaCopyFunc != NULL || node->data == NULL)
     {
-        tree->root = newNode;
+        return 0;
     }
-    else if (addNewNode(tree->root, newNode, tree->compFunc) == 0)
+    if (tree->inlineKeySize != 0 && node->data == inlineKeyBuffer(tree, node))
     {
-        free(newNode);
-        return FAILURE;
+        return 0;
     }
-    modifyNode(newNode, tree);
-    tree->size += 1;
-    return SUCCESS;
+    return tree->sizeFunc(node->data);
 }
 
 /**
- * check whether the tree contains this item.
- * @param tree: the tree to add an item to.
- * @param data: item to check.
- * @return: 0 if the item is not in the tree, other if it is.
+ * @brief climbs from the given node up to the lowest node whose subtree is where the given data
+ * belongs, using the ancestors that bound the subtrees on the way. in a threaded tree, the
+ * neighbour of the node is tried first, so data that belongs right next to the node takes O(1).
+ * @param tree the tree to search in
+ * @param start a node of the tree to start from
+ * @param data the data to find a place for
+ * @param compare set to the result of comparing the data with the returned node (0 if it holds a
+ * data equal to the given one), so the search down goes on from its child
+ * @return the node to search down from, or the node with the same data
  */
-int containsRBTree(RBTree *tree, void *data)
+Node *climbToSubtreeOf(RBTree *tree, Node *start, const void *data, int *compare)
 {
-    if (tree == NULL || data == NULL || tree->root == NULL)
+    *compare = tree->compFunc(data, start->data);
+    if (*compare == 0)
     {
-        return FAILURE;
+        return start;
     }
-    Node *curNode = tree->root;
-    while (curNode != NULL && curNode->data != NULL)
+    int direction = *compare > 0 ? RIGHT_CHILD : LEFT_CHILD;
+    if (tree->isThreaded)
     {
-        int comp = tree->compFunc(curNode->data, data);
-        if (comp == 0)
+        // the neighbour on this side is the bound of start on this side, or lies below it
+        Node *neighbour = direction == RIGHT_CHILD ? linksOf(tree, start)->next
+                                                   : linksOf(tree, start)->prev;
+        if (neighbour == NULL)
         {
-            return SUCCESS;
+            return start;
         }
-        else if (comp > 0)
+        int neighbourCompare = tree->compFunc(data, neighbour->data);
+        if (neighbourCompare == 0)
         {
-            curNode = curNode->left;
+            *compare = 0;
+            return neighbour;
         }
-        else if (comp < 0)
+        if ((neighbourCompare > 0 ? RIGHT_CHILD : LEFT_CHILD) != direction)
         {
-            curNode = curNode->right;
+            // the data goes between the two, under the one that has no child towards the other
+            Node *towards = direction == RIGHT_CHILD ? start->right : start->left;
+            if (towards == NULL)
+            {
+                return start;
+            }
+            *compare = neighbourCompare;
+            return neighbour;
+        }
+    }
+    Node *curNode = start;
+    while (1)
+    {
+        // the subtree of curNode is bounded on this side by the first ancestor that it is not
+        // on this side of
+        Node *bounded = curNode;
+        while (bounded->parent != NULL && isRightChild(bounded) == direction)
+        {
+            bounded = bounded->parent;
+        }
+        Node *bound = bounded->parent;
+        if (bound == NULL)
+        {
+            return curNode;
+        }
+        int boundCompare = tree->compFunc(data, bound->data);
+        if (boundCompare == 0)
+        {
+            *compare = 0;
+            return bound;
         }
+        if ((boundCompare > 0 ? RIGHT_CHILD : LEFT_CHILD) != direction)
+        {
+            // curNode is start or a former bound, so the data is on this side of it too
+            return curNode;
+        }
+        curNode = bound;
     }
-    return FAILURE;
 }
 
 /**
- * @brief goes over the tree from the smallest node to the biggest one by recursion
- * @param node the current node we are looking at
- * @param func the function to invoke on the node given
- * @param args optional argument that the function might use
- * @return: 0 on failure in any step, other on success.
+ * @brief adds the given data to the tree, unless an equal data is already in it. searches the tree
+ * only once, and allocates a node only if the data is new.
+ * @param tree the tree to add the data to
+ * @param data the data to add
+ * @param hint a node of the tree to start the search from, NULL to start from the root
+ * @param inserted set to 1 if a new node was added, and to 0 otherwise
+ * @return the node of the data: the new one, or the one that was already in the tree. NULL if
+ * the allocation failed.
  */
-int forEachNode(Node *node, forEachFunc func, void *args)
+Node *insertData(RBTree *tree, void *data, Node *hint, int *inserted)
 {
-    if (node->left != NULL)
+    Node *parent = NULL;
+    int compare = 0;
+    *inserted = 0;
+    if (tree->root != NULL)
     {
-        if (forEachNode(node->left, func, args) == FAILURE)
+        if (hint != NULL)
         {
-            return FAILURE;
+            parent = climbToSubtreeOf(tree, hint, data, &compare);
+            parent = findAddPlaceBelow(parent, data, tree->compFunc, &compare);
+        }
+        else
+        {
+            parent = findAddPlace(tree->root, data, tree->compFunc, &compare);
+        }
+        if (compare == 0)
+        {
+            return parent;
+        }
+    }
+    Node *newNode = makeNewNode(tree, data);
+    if (newNode == NULL)
+    {
+        return NULL;
+    }
+    if (parent == NULL)
+    {
+        tree->root = newNode;
+    }
+    else
+    {
+        addNewNode(parent, newNode, compare);
+        updatePath(tree, parent);
+    }
+    if (tree->isThreaded)
+    {
+        if (parent == NULL)
+        {
+            threadNode(tree, newNode, NULL, NULL);
+        }
+        else if (compare < 0)
+        {
+            threadNode(tree, newNode, linksOf(tree, parent)->prev, parent);
+        }
+        else
+        {
+            threadNode(tree, newNode, parent, linksOf(tree, parent)->next);
+        }
+    }
+    modifyNode(newNode, tree);
+    tree->size += 1;
+    tree->dataBytes += ownedDataSize(tree, newNode);
+    *inserted = 1;
+    return newNode;
+}
+
+/**
+ * @brief counts the given item once more in a multiset, when the tree already has an equal item
+ * @param tree the tree to count the item in
+ * @param node the node of the equal item
+ * @param data the item that was added
+ * @param takesData other than 0 if the tree owns the added item, so it is freed (unless the tree
+ * keeps copies of its items, or it is the item of the node itself)
+ * @return 1 on success, 0 if the tree is not a multiset or the count can not grow anymore
+ */
+int countAgain(RBTree *tree, Node *node, void *data, int takesData)
+{
+    if (!tree->isMultiset || *countOf(tree, node) == INT_MAX)
+    {
+        return FAILURE;
+    }
+    *countOf(tree, node) += 1;
+    if (takesData && data != node->data && tree->freeFunc != NULL && tree->inlineKeySize == 0
+        && tree->arenaCopyFunc == NULL)
+    {
+        tree->freeFunc(data);
+    }
+    return SUCCESS;
+}
+
+/**
+ * add an item to the tree. in a multiset, an item that is already in the tree is counted once
+ * more instead, and the tree keeps the item it already has: the added one is freed with the
+ * FreeFunc (unless the tree keeps copies of its items, in which case the caller keeps owning it).
+ * in a map, the item is added as a key with no value (see putRBTree).
+ * @param tree: the tree to add an item to.
+ * @param data: item to add to the tree.
+ * @return: 0 on failure, other on success. (if the item is already in the tree - failure, other
+ * than in a multiset).
+ */
+int addToRBTree(RBTree *tree, void *data)
+{
+    int inserted = 0;
+    Node *node = insertData(tree, data, NULL, &inserted);
+    if (node != NULL && !inserted)
+    {
+        return countAgain(tree, node, data, 1);
+    }
+    return inserted ? SUCCESS : FAILURE;
+}
+
+/**
+ * add an item to the tree if there is no equal item in it, with a single search of the tree.
+ * @param tree: the tree to add an item to.
+ * @param data: item to add to the tree.
+ * @param inserted: set to other than 0 if the item was added, and to 0 if an equal item was
+ * already in the tree (may be NULL).
+ * @return: the item in the tree (the one that was already there, or the added one - which is the
+ * copy, in a tree that copies its items). NULL on failure. in a multiset, an item that was
+ * already there is counted once more, and the caller keeps owning the given item. if its count
+ * is already INT_MAX, it is not counted and NULL is returned.
+ */
+void *insertOrGetRBTree(RBTree *tree, void *data, int *inserted)
+{
+    int wasInserted = 0;
+    if (inserted != NULL)
+    {
+        *inserted = 0;
+    }
+    if (tree == NULL || data == NULL)
+    {
+        return NULL;
+    }
+    Node *node = insertData(tree, data, NULL, &wasInserted);
+    if (node != NULL && !wasInserted && tree->isMultiset && !countAgain(tree, node, data, 0))
+    {
+        // the count can not grow anymore, so the item was not counted
+        return NULL;
+    }
+    if (inserted != NULL)
+    {
+        *inserted = wasInserted;
+    }
+    return node != NULL ? node->data : NULL;
+}
+
+/**
+ * add a run of sorted items to the tree. every item is searched for from the place of the item
+ * before it, so close items cost only a few comparisons each.
+ * @param tree: the tree to add the items to.
+ * @param items: the items, in an ascending order (any order works, but slower).
+ * @param n: the amount of items.
+ * @param results: may be NULL. results[i] is set to 0 if items[i] failed to be added (if it is
+ * already in the tree, or on an allocation failure), and to other on success.
+ * @return: the amount of items that were added. in a multiset, the items that were already in
+ * the tree are counted and freed like addToRBTree does, and are added to the amount.
+ */
+int addSortedToRBTree(RBTree *tree, void **items, int n, int *results)
+{
+    if (tree == NULL || items == NULL)
+    {
+        return 0;
+    }
+    int added = 0;
+    Node *finger = NULL;
+    for (int i = 0; i < n; i++)
+    {
+        int inserted = 0;
+        Node *node = insertData(tree, items[i], finger, &inserted);
+        if (node != NULL)
+        {
+            finger = node;
+            if (!inserted)
+            {
+                inserted = countAgain(tree, node, items[i], 1);
+            }
+        }
+        added += inserted;
+        if (results != NULL)
+        {
+            results[i] = inserted ? SUCCESS : FAILURE;
+        }
+    }
+    return added;
+}
+
+/**
+ * add an item to the tree, searching for its place from the item of a cursor instead of from the
+ * root: the search climbs only as far as the item is from the cursor. adding items that are
+ * mostly increasing with a cursor that was put on the last item (by cursorLastRBTree) takes O(1)
+ * comparisons each, and so does adding mostly decreasing items from the first item. in a threaded
+ * tree, the climb itself takes O(1) too. works like addToRBTree otherwise.
+ * @param tree: the tree to add an item to.
+ * @param data: item to add to the tree.
+ * @param cursor: the cursor to start the search from (a cursor with no item, or on another tree,
+ * starts from the root). it is moved to the added item, or to the item that was already in the
+ * tree, so adding the next item starts from there.
+ * @return: 0 on failure, other on success. (if the item is already in the tree - failure, other
+ * than in a multiset).
+ */
+int addNearRBTree(RBTree *tree, void *data, RBTreeCursor *cursor)
+{
+    if (tree == NULL || data == NULL || cursor == NULL)
+    {
+        return FAILURE;
+    }
+    Node *hint = cursor->tree == tree ? cursor->node : NULL;
+    int inserted = 0;
+    Node *node = insertData(tree, data, hint, &inserted);
+    if (node == NULL)
+    {
+        return FAILURE;
+    }
+    cursor->tree = tree;
+    cursor->node = node;
+    return inserted ? SUCCESS : countAgain(tree, node, data, 1);
+}
+
+/**
+ * @brief builds a perfectly balanced subtree out of a sorted range of items. the nodes of the
+ * deepest level are red when that level is not full, and all the other nodes are black.
+ * @param tree the tree to build the nodes for
+ * @param items the sorted items
+ * @param from the index of the first item of the range
+ * @param to the index after the last item of the range
+ * @param depth the depth of the root of the subtree
+ * @param redDepth the depth of the red nodes (-1 if there are none)
+ * @param subtree the root of the built subtree is put here (NULL for an empty range)
+ * @return 1 on success, 0 if an allocation failed (the nodes that were made are left linked)
+ */
+int buildSubtree(RBTree *tree, void **items, int from, int to, int depth, int redDepth,
+                 Node **subtree)
+{
+    *subtree = NULL;
+    if (from >= to)
+    {
+        return SUCCESS;
+    }
+    int middle = from + (to - from) / 2;
+    Node *node = makeNewNode(tree, items[middle]);
+    if (node == NULL)
+    {
+        return FAILURE;
+    }
+    node->color = depth == redDepth ? RED : BLACK;
+    *subtree = node;
+    tree->size += 1;
+    tree->dataBytes += ownedDataSize(tree, node);
+    int leftBuilt = buildSubtree(tree, items, from, middle, depth + 1, redDepth, &node->left);
+    if (node->left != NULL)
+    {
+        node->left->parent = node;
+    }
+    if (leftBuilt == FAILURE)
+    {
+        return FAILURE;
+    }
+    if (tree->isThreaded)
+    {
+        // the nodes before this one are done, so it is the last one so far
+        threadNode(tree, node, tree->last, NULL);
+    }
+    int rightBuilt = buildSubtree(tree, items, middle + 1, to, depth + 1, redDepth, &node->right);
+    if (node->right != NULL)
+    {
+        node->right->parent = node;
+    }
+    updateNode(tree, node);
+    return rightBuilt;
+}
+
+/**
+ * constructs a new RBTree out of items that are already sorted, in O(n) and with no calls to the
+ * CompareFunc (other than for checking the order, when asked to).
+ * @param items: the items, in an ascending order and with no duplicates.
+ * @param n: the amount of items.
+ * @param compFunc: a function two compare two variables.
+ * @param freeFunc: a function to free the items of the tree (may be NULL).
+ * @param options: the settings of the tree (may be NULL for the default ones).
+ * @param verifyOrder: other than 0 to make sure the items are sorted, with n - 1 comparisons.
+ * @return: the new tree, or NULL on failure (or if the items are not sorted). on failure, the
+ * caller keeps owning the items.
+ */
+RBTree *buildRBTreeFromSorted(void **items, int n, CompareFunc compFunc, FreeFunc freeFunc,
+                              const RBTreeOptions *options, int verifyOrder)
+{
+    if ((items == NULL && n > 0) || n < 0)
+    {
+        return NULL;
+    }
+    if (verifyOrder)
+    {
+        for (int i = 1; i < n; i++)
+        {
+            if (compFunc(items[i - 1], items[i]) >= 0)
+            {
+                return NULL;
+            }
+        }
+    }
+    RBTree *tree = newRBTreeWithOptions(compFunc, freeFunc, options);
+    if (tree == NULL)
+    {
+        return NULL;
+    }
+    // the deepest level is the only one that may not be full, and its nodes are made red
+    int height = 0;
+    while (((size_t) 2 << height) - 1 < (size_t) n)
+    {
+        height++;
+    }
+    int isFull = ((size_t) 2 << height) - 1 == (size_t) n;
+    if (buildSubtree(tree, items, 0, n, 0, isFull ? -1 : height, &tree->root) == FAILURE)
+    {
+        if (tree->inlineKeySize == 0 && tree->arenaCopyFunc == NULL)
+        {
+            tree->freeFunc = NULL; // the items go back to the caller
+        }
+        freeRBTree(tree);
+        return NULL;
+    }
+    return tree;
+}
+
+/**
+ * @brief finds the node that holds the given data
+ * @param tree the tree to search in
+ * @param data the data to search for
+ * @return the node, or NULL if the data is not in the tree
+ */
+Node *findNode(const RBTree *tree, const void *data)
+{
+    Node *curNode = tree->root;
+    while (curNode != NULL && curNode->data != NULL)
+    {
+        int comp = tree->compFunc(curNode->data, data);
+        if (comp == 0)
+        {
+            return curNode;
+        }
+        else if (comp > 0)
+        {
+            curNode = curNode->left;
+        }
+        else if (comp < 0)
+        {
+            curNode = curNode->right;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * check whether the tree contains this item.
+ * @param tree: the tree to add an item to.
+ * @param data: item to check.
+ * @return: 0 if the item is not in the tree, other if it is.
+ */
+int containsRBTree(RBTree *tree, void *data)
+{
+    if (tree == NULL || data == NULL || tree->root == NULL)
+    {
+        return FAILURE;
+    }
+    return findNode(tree, data) != NULL ? SUCCESS : FAILURE;
+}
+
+/**
+ * find an item of the tree, searching for it from the item of a cursor instead of from the root:
+ * the search climbs only as far as the item is from the cursor, so looking up items close to each
+ * other takes O(1) comparisons each (see addNearRBTree).
+ * @param tree: the tree to search in.
+ * @param data: an item equal to the one to find.
+ * @param cursor: the cursor to start the search from (a cursor with no item, or on another tree,
+ * starts from the root). it is moved to the found item, and left as it was if there is none.
+ * @return: the item in the tree, or NULL if it is not in the tree.
+ */
+void *findNearRBTree(RBTree *tree, void *data, RBTreeCursor *cursor)
+{
+    if (tree == NULL || data == NULL || cursor == NULL || tree->root == NULL)
+    {
+        return NULL;
+    }
+    Node *start;
+    int compare;
+    if (cursor->tree == tree && cursor->node != NULL)
+    {
+        start = climbToSubtreeOf(tree, cursor->node, data, &compare);
+        start = findAddPlaceBelow(start, data, tree->compFunc, &compare);
+    }
+    else
+    {
+        start = findAddPlace(tree->root, data, tree->compFunc, &compare);
+    }
+    if (compare != 0)
+    {
+        return NULL;
+    }
+    cursor->tree = tree;
+    cursor->node = start;
+    return start->data;
+}
+
+/**
+ * tell how many times an item was added to a multiset. takes O(log n).
+ * @param tree: the tree to search in.
+ * @param data: item to check.
+ * @return: the amount of times the item is in the tree (0 if it is not in it, and at most 1 if
+ * the tree is not a multiset).
+ */
+int countRBTree(RBTree *tree, void *data)
+{
+    if (tree == NULL || data == NULL)
+    {
+        return 0;
+    }
+    Node *node = findNode(tree, data);
+    return node != NULL ? occurrencesOf(tree, node) : 0;
+}
+
+/**
+ * set the value of a key in a map, with a single search of the tree. a key that is not in the
+ * tree is added with the value. otherwise, the value of the key is replaced in place (and the old
+ * one is freed with the valueFreeFunc), and the tree keeps the key it already has: the given one
+ * is freed with the FreeFunc (unless the tree keeps copies of its keys, in which case the caller
+ * keeps owning it).
+ * @param tree: the map to set the value in.
+ * @param key: the key of the value.
+ * @param value: the value (may be NULL).
+ * @return: 0 on failure (or if the tree is not a map), other on success.
+ */
+int putRBTree(RBTree *tree, void *key, void *value)
+{
+    if (tree == NULL || key == NULL || !tree->isMap)
+    {
+        return FAILURE;
+    }
+    int inserted = 0;
+    Node *node = insertData(tree, key, NULL, &inserted);
+    if (node == NULL)
+    {
+        return FAILURE;
+    }
+    if (!inserted)
+    {
+        if (key != node->data && tree->freeFunc != NULL && tree->inlineKeySize == 0
+            && tree->arenaCopyFunc == NULL)
+        {
+            tree->freeFunc(key);
+        }
+        if (*valueOf(tree, node) != value)
+        {
+            freeValueOf(tree, node);
+        }
+    }
+    *valueOf(tree, node) = value;
+    return SUCCESS;
+}
+
+/**
+ * find the value of a key in a map. takes O(log n).
+ * @param tree: the map to search in.
+ * @param key: the key to search for.
+ * @return: the value of the key, or NULL if the key is not in the tree (or if the tree is not a
+ * map).
+ */
+void *getRBTree(RBTree *tree, void *key)
+{
+    if (tree == NULL || key == NULL || !tree->isMap)
+    {
+        return NULL;
+    }
+    Node *node = findNode(tree, key);
+    return node != NULL ? *valueOf(tree, node) : NULL;
+}
+
+/**
+ * @brief puts the given node in the place of the other given node, in the eyes of its parent
+ * @param tree the tree to do the change in
+ * @param toReplace the node to take the place of
+ * @param replaceWith the node to put in its place (may be NULL)
+ */
+void replaceNode(RBTree *tree, Node *toReplace, Node *replaceWith)
+{
+    if (toReplace->parent == NULL)
+    {
+        tree->root = replaceWith;
+    }
+    else if (isRightChild(toReplace) == RIGHT_CHILD)
+    {
+        toReplace->parent->right = replaceWith;
+    }
+    else
+    {
+        toReplace->parent->left = replaceWith;
+    }
+    if (replaceWith != NULL)
+    {
+        replaceWith->parent = toReplace->parent;
+    }
+}
+
+/**
+ * @brief returns the color of the given node, where a NULL leaf is black
+ * @param node the node to check
+ * @return its color
+ */
+Color colorOf(const Node *node)
+{
+    return node == NULL ? BLACK : node->color;
+}
+
+/**
+ * @brief modifies the given tree, that was left with one black node too few on the path to the
+ * given node after a black node was removed
+ * @param node the node that lacks a black node above it (may be NULL)
+ * @param parent the parent of that node
+ * @param tree the tree to do the changes in
+ */
+void modifyRemovedNode(Node *node, Node *parent, RBTree *tree)
+{
+    while (node != tree->root && colorOf(node) == BLACK)
+    {
+        if (node == parent->left)
+        {
+            Node *sibling = parent->right; // not NULL: it has a black node on its side
+            if (sibling->color == RED)
+            {
+                sibling->color = BLACK;
+                parent->color = RED;
+                rightRightSwitch(sibling, parent, tree);
+                sibling = parent->right;
+            }
+            if (colorOf(sibling->left) == BLACK && colorOf(sibling->right) == BLACK)
+            {
+                sibling->color = RED;
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+            if (colorOf(sibling->right) == BLACK)
+            {
+                sibling->left->color = BLACK;
+                sibling->color = RED;
+                leftLeftSwitch(sibling->left, sibling, tree);
+                sibling = parent->right;
+            }
+            sibling->color = parent->color;
+            parent->color = BLACK;
+            sibling->right->color = BLACK;
+            rightRightSwitch(sibling, parent, tree);
+        }
+        else
+        {
+            Node *sibling = parent->left;
+            if (sibling->color == RED)
+            {
+                sibling->color = BLACK;
+                parent->color = RED;
+                leftLeftSwitch(sibling, parent, tree);
+                sibling = parent->left;
+            }
+            if (colorOf(sibling->left) == BLACK && colorOf(sibling->right) == BLACK)
+            {
+                sibling->color = RED;
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+            if (colorOf(sibling->left) == BLACK)
+            {
+                sibling->right->color = BLACK;
+                sibling->color = RED;
+                rightRightSwitch(sibling->right, sibling, tree);
+                sibling = parent->left;
+            }
+            sibling->color = parent->color;
+            parent->color = BLACK;
+            sibling->left->color = BLACK;
+            leftLeftSwitch(sibling, parent, tree);
+        }
+        node = tree->root;
+    }
+    if (node != NULL)
+    {
+        node->color = BLACK;
+    }
+}
+
+/**
+ * @brief unlinks the given node from the tree and rebalances the tree. the node itself and its
+ * data are left for the caller.
+ * @param tree the tree to remove the node from
+ * @param toRemove a node of the tree
+ */
+void unlinkNode(RBTree *tree, Node *toRemove)
+{
+    if (tree->isThreaded)
+    {
+        unthreadNode(tree, toRemove);
+    }
+    Node *child, *childParent;
+    Color removedColor = toRemove->color;
+    if (toRemove->left == NULL || toRemove->right == NULL)
+    {
+        child = toRemove->left != NULL ? toRemove->left : toRemove->right;
+        childParent = toRemove->parent;
+        replaceNode(tree, toRemove, child);
+    }
+    else
+    {
+        // the successor (which has no left child) takes the place of the removed node
+        Node *successor = toRemove->right;
+        while (successor->left != NULL)
+        {
+            successor = successor->left;
+        }
+        removedColor = successor->color;
+        child = successor->right;
+        if (successor->parent == toRemove)
+        {
+            childParent = successor;
+        }
+        else
+        {
+            childParent = successor->parent;
+            replaceNode(tree, successor, successor->right);
+            successor->right = toRemove->right;
+            successor->right->parent = successor;
+        }
+        replaceNode(tree, toRemove, successor);
+        successor->left = toRemove->left;
+        successor->left->parent = successor;
+        successor->color = toRemove->color;
+    }
+    updatePath(tree, childParent);
+    if (removedColor == BLACK)
+    {
+        modifyRemovedNode(child, childParent, tree);
+    }
+}
+
+/**
+ * @brief removes the node that holds the given data from the tree, and releases the node
+ * @param tree the tree to remove from
+ * @param data the data to remove
+ * @param freeData other than 0 to free the data with the FreeFunc of the tree
+ * @param removedData the data of the removed node is put here (if not NULL)
+ * @param onlyOnce other than 0 to only count the data once less, in a multiset where it was added
+ * more than once (in which case nothing is put in removedData)
+ * @return 1 if the data was removed, 0 if it is not in the tree
+ */
+int removeNode(RBTree *tree, const void *data, int freeData, void **removedData, int onlyOnce)
+{
+    Node *toRemove = findNode(tree, data);
+    if (toRemove == NULL)
+    {
+        return FAILURE;
+    }
+    if (onlyOnce && tree->isMultiset && *countOf(tree, toRemove) > 1)
+    {
+        *countOf(tree, toRemove) -= 1;
+        return SUCCESS;
+    }
+    unlinkNode(tree, toRemove);
+    tree->size -= 1;
+    tree->dataBytes -= ownedDataSize(tree, toRemove);
+    freeValueOf(tree, toRemove);
+    void *removed = toRemove->data;
+    int isInline = tree->inlineKeySize != 0 && removed == inlineKeyBuffer(tree, toRemove);
+    if (!tree->isIntrusive)
+    {
+        slabFree(&tree->nodeSlab, toRemove);
+    }
+    // the data of an intrusive tree holds its node, so it is freed only once the node is unlinked
+    if (freeData && tree->freeFunc != NULL && tree->arenaCopyFunc == NULL && !isInline)
+    {
+        tree->freeFunc(removed);
+    }
+    if (removedData != NULL)
+    {
+        *removedData = removed;
+    }
+    return SUCCESS;
+}
+
+/**
+ * remove an item from the tree, and free it with the FreeFunc of the tree. in a multiset, an item
+ * that was added more than once is only counted once less. in a map, the value of the item is
+ * freed with the valueFreeFunc.
+ * @param tree: the tree to remove an item from.
+ * @param data: an item equal to the one to remove.
+ * @return: 0 on failure, other on success. (if the item is not in the tree - failure).
+ */
+int removeFromRBTree(RBTree *tree, void *data)
+{
+    if (tree == NULL || data == NULL)
+    {
+        return FAILURE;
+    }
+    return removeNode(tree, data, 1, NULL, 1);
+}
+
+/**
+ * remove an item from the tree without freeing it, and hand it back to the caller. in a multiset,
+ * the item is taken out however many times it was added. in a map, the value of the item is freed
+ * with the valueFreeFunc.
+ * @param tree: the tree to remove an item from.
+ * @param data: an item equal to the one to remove.
+ * @return: the removed item, which the caller now owns, or NULL if it is not in the tree.
+ */
+void *takeFromRBTree(RBTree *tree, void *data)
+{
+    if (tree == NULL || data == NULL || tree->inlineKeySize != 0)
+    {
+        return NULL;
+    }
+    void *removed = NULL;
+    removeNode(tree, data, 0, &removed, 0);
+    return removed;
+}
+
+/**
+ * @brief goes over the tree from the smallest node to the biggest one by recursion
+ * @param node the current node we are looking at
+ * @param func the function to invoke on the node given
+ * @param args optional argument that the function might use
+ * @return: 0 on failure in any step, other on success.
+ */
+int forEachNode(Node *node, forEachFunc func, void *args)
+{
+    if (node->left != NULL)
+    {
+        if (forEachNode(node->left, func, args) == FAILURE)
+        {
+            return FAILURE;
         }
     }
     if (func(node->data, args) == 0)
     {
         return FAILURE;
     }
-    if (node->right != NULL)
+    if (node->right != NULL)
+    {
+        if (forEachNode(node->right, func, args) == FAILURE)
+        {
+            return FAILURE;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * Activate a function on each item of the tree. the order is an ascending order. if one of the activations of the
+ * function returns 0, the process stops.
+ * @param tree: the tree with all the items.
+ * @param func: the function to activate on all items.
+ * @param args: more optional arguments to the function (may be null if the given function support it).
+ * @return: 0 on failure, other on success.
+ */
+int forEachRBTree(RBTree *tree, forEachFunc func, void *args)
+{
+    if (tree == NULL || func == NULL)
+    {
+        return FAILURE;
+    }
+    if (tree->root == NULL)
+    {
+        return SUCCESS;
+    }
+    if (tree->isThreaded)
+    {
+        for (Node *curNode = tree->first; curNode != NULL; curNode = linksOf(tree, curNode)->next)
+        {
+            if (func(curNode->data, args) == 0)
+            {
+                return FAILURE;
+            }
+        }
+        return SUCCESS;
+    }
+    return forEachNode(tree->root, func, args);
+}
+
+/**
+ * @brief finds the first node whose data is greater than the given data (or equal to it)
+ * @param tree the tree to search in
+ * @param data the data to compare with
+ * @param allowEqual other than 0 to accept a node equal to the data
+ * @return the node, or NULL if there is none
+ */
+Node *firstNodeAbove(const RBTree *tree, const void *data, int allowEqual)
+{
+    Node *found = NULL;
+    Node *curNode = tree->root;
+    while (curNode != NULL)
+    {
+        int comp = tree->compFunc(curNode->data, data);
+        if (comp > 0 || (allowEqual && comp == 0))
+        {
+            found = curNode;
+            if (comp == 0)
+            {
+                return found;
+            }
+            curNode = curNode->left;
+        }
+        else
+        {
+            curNode = curNode->right;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief finds the last node whose data is smaller than the given data (or equal to it)
+ * @param tree the tree to search in
+ * @param data the data to compare with
+ * @param allowEqual other than 0 to accept a node equal to the data
+ * @return the node, or NULL if there is none
+ */
+Node *lastNodeBelow(const RBTree *tree, const void *data, int allowEqual)
+{
+    Node *found = NULL;
+    Node *curNode = tree->root;
+    while (curNode != NULL)
+    {
+        int comp = tree->compFunc(curNode->data, data);
+        if (comp < 0 || (allowEqual && comp == 0))
+        {
+            found = curNode;
+            if (comp == 0)
+            {
+                return found;
+            }
+            curNode = curNode->right;
+        }
+        else
+        {
+            curNode = curNode->left;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief finds the node that comes right after the given node in the order of the tree
+ * @param tree the tree of the node
+ * @param node a node of the tree
+ * @return the next node, or NULL if the given node is the last one
+ */
+Node *nextNode(const RBTree *tree, Node *node)
+{
+    if (tree->isThreaded)
+    {
+        return linksOf(tree, node)->next;
+    }
+    if (node->right != NULL)
+    {
+        node = node->right;
+        while (node->left != NULL)
+        {
+            node = node->left;
+        }
+        return node;
+    }
+    while (isRightChild(node) == RIGHT_CHILD)
+    {
+        node = node->parent;
+    }
+    return node->parent;
+}
+
+/**
+ * @brief finds the node that comes right before the given node in the order of the tree
+ * @param tree the tree of the node
+ * @param node a node of the tree
+ * @return the previous node, or NULL if the given node is the first one
+ */
+Node *previousNode(const RBTree *tree, Node *node)
+{
+    if (tree->isThreaded)
+    {
+        return linksOf(tree, node)->prev;
+    }
+    if (node->left != NULL)
+    {
+        node = node->left;
+        while (node->right != NULL)
+        {
+            node = node->right;
+        }
+        return node;
+    }
+    while (isRightChild(node) == LEFT_CHILD)
+    {
+        node = node->parent;
+    }
+    return node->parent;
+}
+
+/**
+ * @brief returns the data of the given node
+ * @param node the node (may be NULL)
+ * @return its data, or NULL if there is no node
+ */
+void *dataOf(const Node *node)
+{
+    return node != NULL ? node->data : NULL;
+}
+
+/**
+ * find the smallest item that is not smaller than the given item. takes O(log n).
+ * @param tree: the tree to search in.
+ * @param data: the item to compare with (does not have to be in the tree).
+ * @return: the found item, or NULL if there is none.
+ */
+void *lowerBoundRBTree(RBTree *tree, void *data)
+{
+    if (tree == NULL || data == NULL)
+    {
+        return NULL;
+    }
+    return dataOf(firstNodeAbove(tree, data, 1));
+}
+
+/**
+ * find the smallest item that is greater than the given item. takes O(log n).
+ * @param tree: the tree to search in.
+ * @param data: the item to compare with (does not have to be in the tree).
+ * @return: the found item, or NULL if there is none.
+ */
+void *upperBoundRBTree(RBTree *tree, void *data)
+{
+    if (tree == NULL || data == NULL)
+    {
+        return NULL;
+    }
+    return dataOf(firstNodeAbove(tree, data, 0));
+}
+
+/**
+ * find the greatest item that is not greater than the given item. takes O(log n).
+ * @param tree: the tree to search in.
+ * @param data: the item to compare with (does not have to be in the tree).
+ * @return: the found item, or NULL if there is none.
+ */
+void *floorRBTree(RBTree *tree, void *data)
+{
+    if (tree == NULL || data == NULL)
+    {
+        return NULL;
+    }
+    return dataOf(lastNodeBelow(tree, data, 1));
+}
+
+/**
+ * find the smallest item that is not smaller than the given item (the same as lowerBoundRBTree).
+ * takes O(log n).
+ * @param tree: the tree to search in.
+ * @param data: the item to compare with (does not have to be in the tree).
+ * @return: the found item, or NULL if there is none.
+ */
+void *ceilingRBTree(RBTree *tree, void *data)
+{
+    return lowerBoundRBTree(tree, data);
+}
+
+/**
+ * Activate a function on each item of the tree between two items (including them), in an
+ * ascending order. if one of the activations of the function returns 0, the process stops.
+ * takes O(log n + k) for k items in the range.
+ * @param tree: the tree with all the items.
+ * @param low: the lowest item of the range (does not have to be in the tree).
+ * @param high: the highest item of the range (does not have to be in the tree).
+ * @param func: the function to activate on the items.
+ * @param args: more optional arguments to the function (may be null if the given function support it).
+ * @return: 0 on failure, other on success.
+ */
+int forEachInRangeRBTree(RBTree *tree, void *low, void *high, forEachFunc func, void *args)
+{
+    if (tree == NULL || low == NULL || high == NULL || func == NULL)
+    {
+        return FAILURE;
+    }
+    Node *curNode = firstNodeAbove(tree, low, 1);
+    while (curNode != NULL && tree->compFunc(curNode->data, high) <= 0)
+    {
+        if (func(curNode->data, args) == 0)
+        {
+            return FAILURE;
+        }
+        curNode = nextNode(tree, curNode);
+    }
+    return SUCCESS;
+}
+
+/**
+ * Activate a function on each item of the tree between two items (including them), in a
+ * descending order. if one of the activations of the function returns 0, the process stops.
+ * takes O(log n + k) for k items in the range.
+ * @param tree: the tree with all the items.
+ * @param low: the lowest item of the range (does not have to be in the tree).
+ * @param high: the highest item of the range (does not have to be in the tree).
+ * @param func: the function to activate on the items.
+ * @param args: more optional arguments to the function (may be null if the given function support it).
+ * @return: 0 on failure, other on success.
+ */
+int forEachInRangeReverseRBTree(RBTree *tree, void *low, void *high, forEachFunc func, void *args)
+{
+    if (tree == NULL || low == NULL || high == NULL || func == NULL)
+    {
+        return FAILURE;
+    }
+    Node *curNode = lastNodeBelow(tree, high, 1);
+    while (curNode != NULL && tree->compFunc(curNode->data, low) >= 0)
+    {
+        if (func(curNode->data, args) == 0)
+        {
+            return FAILURE;
+        }
+        curNode = previousNode(tree, curNode);
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief finds the node with the smallest data in the subtree of the given node
+ * @param node the root of the subtree (may be NULL)
+ * @return the node, or NULL for an empty subtree
+ */
+Node *firstNode(Node *node)
+{
+    while (node != NULL && node->left != NULL)
+    {
+        node = node->left;
+    }
+    return node;
+}
+
+/**
+ * @brief finds the node with the greatest data in the subtree of the given node
+ * @param node the root of the subtree (may be NULL)
+ * @return the node, or NULL for an empty subtree
+ */
+Node *lastNode(Node *node)
+{
+    while (node != NULL && node->right != NULL)
+    {
+        node = node->right;
+    }
+    return node;
+}
+
+/**
+ * Activate a function on each item of the tree with the amount of times it is in the tree (1 for
+ * every item, if the tree is not a multiset). the order is an ascending order. if one of the
+ * activations of the function returns 0, the process stops.
+ * @param tree: the tree with all the items.
+ * @param func: the function to activate on all items.
+ * @param args: more optional arguments to the function (may be null if the given function support it).
+ * @return: 0 on failure, other on success.
+ */
+int forEachCountRBTree(RBTree *tree, forEachCountFunc func, void *args)
+{
+    if (tree == NULL || func == NULL)
+    {
+        return FAILURE;
+    }
+    for (Node *curNode = firstNode(tree->root); curNode != NULL; curNode = nextNode(tree, curNode))
+    {
+        if (func(curNode->data, occurrencesOf(tree, curNode), args) == 0)
+        {
+            return FAILURE;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * Activate a function on each key of a map with its value. the order is an ascending order of the
+ * keys. the function may change the values in place. if one of the activations of the function
+ * returns 0, the process stops.
+ * @param tree: the map with all the keys.
+ * @param func: the function to activate on all the keys.
+ * @param args: more optional arguments to the function (may be null if the given function support it).
+ * @return: 0 on failure (or if the tree is not a map), other on success.
+ */
+int forEachPairRBTree(RBTree *tree, forEachPairFunc func, void *args)
+{
+    if (tree == NULL || func == NULL || !tree->isMap)
+    {
+        return FAILURE;
+    }
+    for (Node *curNode = firstNode(tree->root); curNode != NULL; curNode = nextNode(tree, curNode))
+    {
+        if (func(curNode->data, *valueOf(tree, curNode), args) == 0)
+        {
+            return FAILURE;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * Activate a function on each item of the tree between two items (including them) with the
+ * amount of times it is in the tree, in an ascending order. if one of the activations of the
+ * function returns 0, the process stops. takes O(log n + k) for k items in the range.
+ * @param tree: the tree with all the items.
+ * @param low: the lowest item of the range (does not have to be in the tree).
+ * @param high: the highest item of the range (does not have to be in the tree).
+ * @param func: the function to activate on the items.
+ * @param args: more optional arguments to the function (may be null if the given function support it).
+ * @return: 0 on failure, other on success.
+ */
+int forEachInRangeCountRBTree(RBTree *tree, void *low, void *high, forEachCountFunc func,
+                              void *args)
+{
+    if (tree == NULL || low == NULL || high == NULL || func == NULL)
+    {
+        return FAILURE;
+    }
+    Node *curNode = firstNodeAbove(tree, low, 1);
+    while (curNode != NULL && tree->compFunc(curNode->data, high) <= 0)
+    {
+        if (func(curNode->data, occurrencesOf(tree, curNode), args) == 0)
+        {
+            return FAILURE;
+        }
+        curNode = nextNode(tree, curNode);
+    }
+    return SUCCESS;
+}
+
+/**
+ * find the smallest item of the tree. takes O(1) in a threaded tree, and O(log n) otherwise.
+ * @param tree: the tree to search in.
+ * @return: the smallest item, or NULL if the tree is empty.
+ */
+void *minRBTree(RBTree *tree)
+{
+    if (tree == NULL)
+    {
+        return NULL;
+    }
+    return dataOf(tree->isThreaded ? tree->first : firstNode(tree->root));
+}
+
+/**
+ * find the greatest item of the tree. takes O(1) in a threaded tree, and O(log n) otherwise.
+ * @param tree: the tree to search in.
+ * @return: the greatest item, or NULL if the tree is empty.
+ */
+void *maxRBTree(RBTree *tree)
+{
+    if (tree == NULL)
+    {
+        return NULL;
+    }
+    return dataOf(tree->isThreaded ? tree->last : lastNode(tree->root));
+}
+
+/**
+ * find the item with the greatest score, in a tree that was made with a maxScoreFunc. takes O(1).
+ * if some items share the greatest score, the smallest of them is returned.
+ * @param tree: the tree to search in.
+ * @return: the item (which still belongs to the tree), or NULL if the tree is empty or has no
+ * maxScoreFunc.
+ */
+void *maxScoreRBTree(RBTree *tree)
+{
+    if (tree == NULL || tree->maxScoreFunc == NULL || tree->root == NULL)
+    {
+        return NULL;
+    }
+    return maxScoreOf(tree, tree->root)->maxData;
+}
+
+/**
+ * put the cursor on the smallest item of the tree.
+ * @param tree: the tree to walk over.
+ * @param cursor: the cursor to set.
+ * @return: the item, or NULL if the tree is empty.
+ */
+void *cursorFirstRBTree(RBTree *tree, RBTreeCursor *cursor)
+{
+    if (tree == NULL || cursor == NULL)
+    {
+        return NULL;
+    }
+    cursor->tree = tree;
+    cursor->node = tree->isThreaded ? tree->first : firstNode(tree->root);
+    return dataOf(cursor->node);
+}
+
+/**
+ * put the cursor on the greatest item of the tree.
+ * @param tree: the tree to walk over.
+ * @param cursor: the cursor to set.
+ * @return: the item, or NULL if the tree is empty.
+ */
+void *cursorLastRBTree(RBTree *tree, RBTreeCursor *cursor)
+{
+    if (tree == NULL || cursor == NULL)
+    {
+        return NULL;
+    }
+    cursor->tree = tree;
+    cursor->node = tree->isThreaded ? tree->last : lastNode(tree->root);
+    return dataOf(cursor->node);
+}
+
+/**
+ * put the cursor on the smallest item that is not smaller than the given item. takes O(log n).
+ * @param tree: the tree to walk over.
+ * @param cursor: the cursor to set.
+ * @param data: the item to compare with (does not have to be in the tree).
+ * @return: the item, or NULL if there is none.
+ */
+void *cursorSeekRBTree(RBTree *tree, RBTreeCursor *cursor, void *data)
+{
+    if (tree == NULL || cursor == NULL || data == NULL)
+    {
+        return NULL;
+    }
+    cursor->tree = tree;
+    cursor->node = firstNodeAbove(tree, data, 1);
+    return dataOf(cursor->node);
+}
+
+/**
+ * move the cursor to the next item. takes amortized O(1).
+ * @param cursor: the cursor to move.
+ * @return: the next item, or NULL if the cursor was on the last item (or past the end).
+ */
+void *cursorNextRBTree(RBTreeCursor *cursor)
+{
+    if (cursor == NULL || cursor->node == NULL)
+    {
+        return NULL;
+    }
+    cursor->node = nextNode(cursor->tree, cursor->node);
+    return dataOf(cursor->node);
+}
+
+/**
+ * move the cursor to the previous item. takes amortized O(1).
+ * @param cursor: the cursor to move.
+ * @return: the previous item, or NULL if the cursor was on the first item (or past the end).
+ */
+void *cursorPrevRBTree(RBTreeCursor *cursor)
+{
+    if (cursor == NULL || cursor->node == NULL)
+    {
+        return NULL;
+    }
+    cursor->node = previousNode(cursor->tree, cursor->node);
+    return dataOf(cursor->node);
+}
+
+/**
+ * @param cursor: a cursor.
+ * @return: the item the cursor is on, or NULL if it is past the end.
+ */
+void *cursorDataRBTree(const RBTreeCursor *cursor)
+{
+    return cursor != NULL ? dataOf(cursor->node) : NULL;
+}
+
+/**
+ * @brief counts the items of the tree that are smaller than the given data (or equal to it)
+ * @param tree a tree with order statistics
+ * @param data the data to compare with
+ * @param countEqual other than 0 to count an item equal to the data too
+ * @return the amount of items
+ */
+int countSmaller(const RBTree *tree, const void *data, int countEqual)
+{
+    int count = 0;
+    Node *curNode = tree->root;
+    while (curNode != NULL)
+    {
+        int comp = tree->compFunc(data, curNode->data);
+        if (comp > 0 || (countEqual && comp == 0))
+        {
+            count += subtreeSizeOf(curNode->left) + 1;
+            curNode = curNode->right;
+        }
+        else
+        {
+            curNode = curNode->left;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief finds the node of the given rank
+ * @param tree a tree with order statistics
+ * @param k the rank, from 0 to the size of the tree minus 1
+ * @return the node, or NULL if the rank is out of range
+ */
+Node *selectNode(const RBTree *tree, int k)
+{
+    Node *curNode = tree->root;
+    while (curNode != NULL)
+    {
+        int leftSize = subtreeSizeOf(curNode->left);
+        if (k < leftSize)
+        {
+            curNode = curNode->left;
+        }
+        else if (k == leftSize)
+        {
+            return curNode;
+        }
+        else
+        {
+            k -= leftSize + 1;
+            curNode = curNode->right;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * tell the rank of an item: the amount of items in the tree that are smaller than it. takes
+ * O(log n) in a tree with order statistics.
+ * @param tree: the tree to search in.
+ * @param data: the item to rank (does not have to be in the tree).
+ * @return: the rank, or -1 on failure (or if the tree has no order statistics).
+ */
+int rankRBTree(RBTree *tree, void *data)
+{
+    if (tree == NULL || data == NULL || !tree->hasOrderStatistics)
+    {
+        return -1;
+    }
+    return countSmaller(tree, data, 0);
+}
+
+/**
+ * find the item of the given rank. takes O(log n) in a tree with order statistics.
+ * @param tree: the tree to search in.
+ * @param k: the rank of the item, from 0 (the smallest item) to the size of the tree minus 1.
+ * @return: the item, or NULL if there is no such item (or if the tree has no order statistics).
+ */
+void *selectRBTree(RBTree *tree, int k)
+{
+    if (tree == NULL || !tree->hasOrderStatistics || k < 0)
+    {
+        return NULL;
+    }
+    Node *node = selectNode(tree, k);
+    return node != NULL ? node->data : NULL;
+}
+
+/**
+ * count the items between two items (including them). takes O(log n) in a tree with order
+ * statistics.
+ * @param tree: the tree to count in.
+ * @param low: the lowest item of the range (does not have to be in the tree).
+ * @param high: the highest item of the range (does not have to be in the tree).
+ * @return: the amount of items in the range, or -1 on failure (or if the tree has no order
+ * statistics).
+ */
+int countRangeRBTree(RBTree *tree, void *low, void *high)
+{
+    if (tree == NULL || low == NULL || high == NULL || !tree->hasOrderStatistics)
+    {
+        return -1;
+    }
+    int count = countSmaller(tree, high, 1) - countSmaller(tree, low, 0);
+    return count > 0 ? count : 0;
+}
+
+/**
+ * pick an item of the tree uniformly at random. takes O(log n) in a tree with order statistics.
+ * @param tree: the tree to pick from.
+ * @param randomValue: a uniformly random number, from the random source of the caller.
+ * @return: the item, or NULL if the tree is empty (or has no order statistics).
+ */
+void *sampleRBTree(RBTree *tree, unsigned long long randomValue)
+{
+    if (tree == NULL || !tree->hasOrderStatistics || tree->root == NULL)
+    {
+        return NULL;
+    }
+    return selectRBTree(tree, (int) (randomValue % (unsigned long long) tree->root->subtreeSize));
+}
+
+/**
+ * get the aggregate of all the items of the tree, in a tree that keeps aggregates. takes O(1).
+ * @param tree: the tree to get the aggregate of.
+ * @return: the aggregate (which belongs to the tree, and changes with it), or NULL if the tree is
+ * empty (or keeps no aggregates).
+ */
+const void *aggregateRBTree(RBTree *tree)
+{
+    if (tree == NULL || tree->aggregateSize == 0 || tree->root == NULL)
+    {
+        return NULL;
+    }
+    return aggregateOf(tree, tree->root);
+}
+
+/**
+ * @brief adds the aggregate of a run of items to the aggregate of the runs that were collected
+ * so far, on its left or on its right
+ * @param tree the tree the runs are from
+ * @param collected the aggregate of the runs so far
+ * @param hasCollected set to 1 once the first run is collected
+ * @param run the aggregate of the run to add
+ * @param onTheLeft other than 0 if the run comes before the collected runs, 0 if after them
+ */
+void collectAggregate(const RBTree *tree, void *collected, int *hasCollected, const void *run,
+                      int onTheLeft)
+{
+    if (!*hasCollected)
+    {
+        memcpy(collected, run, tree->aggregateSize);
+        *hasCollected = 1;
+    }
+    else if (onTheLeft)
+    {
+        tree->aggregateCombineFunc(collected, run, collected);
+    }
+    else
+    {
+        tree->aggregateCombineFunc(collected, collected, run);
+    }
+}
+
+/**
+ * @brief adds the aggregate of the item of the given node to the aggregate of the runs that were
+ * collected so far, on its left or on its right
+ * @param tree the tree of the node
+ * @param node the node whose item to add
+ * @param itemAggregate room to make the aggregate of the item in
+ * @param collected the aggregate of the runs so far
+ * @param hasCollected set to 1 once the first run is collected
+ * @param onTheLeft other than 0 if the item comes before the collected runs, 0 if after them
+ */
+void collectItemAggregate(const RBTree *tree, const Node *node, void *itemAggregate,
+                          void *collected, int *hasCollected, int onTheLeft)
+{
+    tree->aggregateItemFunc(itemAggregate, node->data);
+    collectAggregate(tree, collected, hasCollected, itemAggregate, onTheLeft);
+}
+
+/**
+ * get the aggregate of the items between two items (including them), in a tree that keeps
+ * aggregates. takes O(log n).
+ * @param tree: the tree to aggregate in.
+ * @param low: the lowest item of the range (does not have to be in the tree).
+ * @param high: the highest item of the range (does not have to be in the tree).
+ * @param result: where to put the aggregate (aggregateSize bytes). left as is if the range is
+ * empty.
+ * @return: 0 on failure or if the range is empty, other on success.
+ */
+int rangeAggregateRBTree(RBTree *tree, void *low, void *high, void *result)
+{
+    if (tree == NULL || low == NULL || high == NULL || result == NULL || tree->aggregateSize == 0)
+    {
+        return FAILURE;
+    }
+    // the highest node that is in the range splits it into a part in its left subtree and a part
+    // in its right subtree
+    Node *split = tree->root;
+    while (split != NULL)
+    {
+        if (tree->compFunc(split->data, low) < 0)
+        {
+            split = split->right;
+        }
+        else if (tree->compFunc(split->data, high) > 0)
+        {
+            split = split->left;
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (split == NULL)
+    {
+        return FAILURE;
+    }
+    double stackRoom[STACK_AGGREGATE_SIZE / sizeof(double)];
+    void *itemAggregate = stackRoom;
+    if (tree->aggregateSize > sizeof(stackRoom))
+    {
+        itemAggregate = malloc(tree->aggregateSize);
+        if (itemAggregate == NULL)
+        {
+            fprintf(stderr, "%s", ERR_MALLOC);
+            return FAILURE;
+        }
+    }
+    int hasCollected = 0;
+    // the left part is collected from its end to its start: every node that is not below low
+    // adds itself and its right subtree before what was collected
+    for (Node *curNode = split->left; curNode != NULL;)
+    {
+        if (tree->compFunc(curNode->data, low) < 0)
+        {
+            curNode = curNode->right;
+            continue;
+        }
+        if (curNode->right != NULL)
+        {
+            collectAggregate(tree, result, &hasCollected, aggregateOf(tree, curNode->right), 1);
+        }
+        collectItemAggregate(tree, curNode, itemAggregate, result, &hasCollected, 1);
+        curNode = curNode->left;
+    }
+    collectItemAggregate(tree, split, itemAggregate, result, &hasCollected, 0);
+    // the right part is collected from its start to its end: every node that is not above high
+    // adds its left subtree and itself after what was collected
+    for (Node *curNode = split->right; curNode != NULL;)
+    {
+        if (tree->compFunc(curNode->data, high) > 0)
+        {
+            curNode = curNode->left;
+            continue;
+        }
+        if (curNode->left != NULL)
+        {
+            collectAggregate(tree, result, &hasCollected, aggregateOf(tree, curNode->left), 0);
+        }
+        collectItemAggregate(tree, curNode, itemAggregate, result, &hasCollected, 0);
+        curNode = curNode->right;
+    }
+    if (itemAggregate != (void *) stackRoom)
+    {
+        free(itemAggregate);
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief checks whether the nodes of one tree can be moved to another tree: both have the same
+ * settings, and their memory can be freed by either of them
+ * @param tree one tree
+ * @param other the other tree
+ * @return 1 if they can, 0 otherwise
+ */
+int canShareNodes(const RBTree *tree, const RBTree *other)
+{
+    return tree->compFunc == other->compFunc && tree->freeFunc == other->freeFunc
+           && tree->isIntrusive == other->isIntrusive && tree->nodeOffset == other->nodeOffset
+           && tree->inlineKeySize == other->inlineKeySize
+           && tree->inlineCopyFunc == other->inlineCopyFunc
+           && tree->arenaCopyFunc == other->arenaCopyFunc && tree->sizeFunc == other->sizeFunc
+           && tree->hasOrderStatistics == other->hasOrderStatistics
+           && tree->isThreaded == other->isThreaded && tree->maxScoreFunc == other->maxScoreFunc
+           && tree->aggregateSize == other->aggregateSize
+           && tree->aggregateItemFunc == other->aggregateItemFunc
+           && tree->aggregateCombineFunc == other->aggregateCombineFunc
+           && tree->isMultiset == other->isMultiset && tree->isMap == other->isMap
+           && tree->valueFreeFunc == other->valueFreeFunc
+           && tree->allocator.alloc == other->allocator.alloc
+           && tree->allocator.free == other->allocator.free
+           && tree->allocator.context == other->allocator.context
+           && tree->allocator.reset == NULL && other->allocator.reset == NULL;
+}
+
+/**
+ * @brief puts the sharing rings of two trees together, so the memory of their nodes is freed
+ * only with the last tree of both
+ * @param tree one tree
+ * @param other the other tree
+ */
+void joinSharingRings(RBTree *tree, RBTree *other)
+{
+    for (RBTree *member = tree->nextSharing; member != tree; member = member->nextSharing)
+    {
+        if (member == other)
+        {
+            return;
+        }
+    }
+    RBTree *next = tree->nextSharing;
+    tree->nextSharing = other->nextSharing;
+    other->nextSharing = next;
+}
+
+/**
+ * @brief takes the given tree out of its sharing ring, and hands the chunks of its nodes and of
+ * its arena to the next tree of the ring, since they may still hold nodes of that tree
+ * @param tree the tree to take out, that is about to be freed
+ */
+void leaveSharingRing(RBTree *tree)
+{
+    RBTree *heir = tree->nextSharing;
+    RBTree *previous = heir;
+    while (previous->nextSharing != tree)
+    {
+        previous = previous->nextSharing;
+    }
+    previous->nextSharing = heir;
+    tree->nextSharing = tree;
+    slabAdopt(&heir->nodeSlab, &tree->nodeSlab);
+    arenaAdopt(&heir->keyArena, &tree->keyArena);
+}
+
+/**
+ * @brief returns the black height of the given subtree: the amount of black nodes on every path
+ * from its root (including it) down to a leaf
+ * @param node the root of the subtree (may be NULL)
+ * @return the black height
+ */
+int blackHeightOf(const Node *node)
+{
+    int height = 0;
+    for (; node != NULL; node = node->left)
+    {
+        height += node->color == BLACK;
+    }
+    return height;
+}
+
+/**
+ * @brief rebalances a subtree that a red node was linked into, and tells whether its black height
+ * grew
+ * @param tree the tree the nodes belong to
+ * @param root the root of the subtree, which is black and has no parent
+ * @param added the red node that was linked into the subtree
+ * @param grew set to 1 if the black height of the subtree grew by one, and to 0 otherwise
+ * @return the new root of the subtree
+ */
+Node *rebalanceSubtree(RBTree *tree, Node *root, Node *added, int *grew)
+{
+    // a black anchor above the root stops the fixing there, so a root that had to be made red is
+    // left red and tells that the black height grew
+    Node anchor = {NULL, root, NULL, BLACK, 0, NULL};
+    Node *treeRoot = tree->root;
+    tree->root = NULL;
+    root->parent = &anchor;
+    modifyNode(added, tree);
+    root = anchor.left;
+    root->parent = NULL;
+    tree->root = treeRoot;
+    *grew = root->color == RED;
+    root->color = BLACK;
+    return root;
+}
+
+/**
+ * @brief joins two subtrees and a node between them into one subtree. takes O(the difference of
+ * their black heights + 1).
+ * @param tree the tree the nodes belong to
+ * @param left the subtree of the smaller items (may be NULL), with no parent
+ * @param leftHeight the black height of left
+ * @param middle a node that is greater than the items of left and smaller than those of right
+ * @param right the subtree of the greater items (may be NULL), with no parent
+ * @param rightHeight the black height of right
+ * @param height the black height of the joined subtree is put here
+ * @return the root of the joined subtree, which is black
+ */
+Node *joinSubtrees(RBTree *tree, Node *left, int leftHeight, Node *middle, Node *right,
+                   int rightHeight, int *height)
+{
+    if (left != NULL && left->color == RED)
+    {
+        left->color = BLACK;
+        leftHeight++;
+    }
+    if (right != NULL && right->color == RED)
+    {
+        right->color = BLACK;
+        rightHeight++;
+    }
+    if (leftHeight == rightHeight)
+    {
+        middle->parent = NULL;
+        middle->left = left;
+        middle->right = right;
+        if (left != NULL)
+        {
+            left->parent = middle;
+        }
+        if (right != NULL)
+        {
+            right->parent = middle;
+        }
+        middle->color = BLACK;
+        updateNode(tree, middle);
+        *height = leftHeight + 1;
+        return middle;
+    }
+    // the lower subtree takes the place of the first black node of the same black height on the
+    // inner side of the higher one, under the middle node
+    int isLeftHigher = leftHeight > rightHeight;
+    Node *higher = isLeftHigher ? left : right;
+    Node *lower = isLeftHigher ? right : left;
+    int lowerHeight = isLeftHigher ? rightHeight : leftHeight;
+    int curHeight = isLeftHigher ? leftHeight : rightHeight;
+    Node *parent = NULL;
+    Node *curNode = higher;
+    while (curNode != NULL && (curNode->color == RED || curHeight > lowerHeight))
+    {
+        curHeight -= curNode->color == BLACK;
+        parent = curNode;
+        curNode = isLeftHigher ? curNode->right : curNode->left;
+    }
+    middle->left = isLeftHigher ? curNode : lower;
+    middle->right = isLeftHigher ? lower : curNode;
+    if (middle->left != NULL)
+    {
+        middle->left->parent = middle;
+    }
+    if (middle->right != NULL)
+    {
+        middle->right->parent = middle;
+    }
+    middle->parent = parent; // not NULL: the root of the higher subtree is black and higher
+    if (isLeftHigher)
+    {
+        parent->right = middle;
+    }
+    else
+    {
+        parent->left = middle;
+    }
+    middle->color = RED;
+    updatePath(tree, middle);
+    int grew = 0;
+    higher = rebalanceSubtree(tree, higher, middle, &grew);
+    *height = (isLeftHigher ? leftHeight : rightHeight) + grew;
+    return higher;
+}
+
+/**
+ * @brief splits the given subtree into the items smaller than the given key and the rest, by
+ * recursion. takes O(the height of the subtree).
+ * @param tree the tree the nodes belong to
+ * @param node the root of the subtree (may be NULL)
+ * @param height the black height of the subtree
+ * @param key the item to split at
+ * @param left the root of the smaller items is put here
+ * @param leftHeight the black height of the smaller items is put here
+ * @param equal if not NULL, the node that is equal to the key is taken out of both parts and put
+ * here (NULL if there is none). if NULL, that node goes with the greater items.
+ * @param right the root of the other items is put here
+ * @param rightHeight the black height of the other items is put here
+ */
+void splitSubtree(RBTree *tree, Node *node, int height, const void *key, Node **left,
+                  int *leftHeight, Node **equal, Node **right, int *rightHeight)
+{
+    if (node == NULL)
+    {
+        *left = NULL;
+        *right = NULL;
+        *leftHeight = 0;
+        *rightHeight = 0;
+        if (equal != NULL)
+        {
+            *equal = NULL;
+        }
+        return;
+    }
+    int childHeight = height - (node->color == BLACK);
+    Node *leftChild = node->left;
+    Node *rightChild = node->right;
+    if (leftChild != NULL)
+    {
+        leftChild->parent = NULL;
+    }
+    if (rightChild != NULL)
+    {
+        rightChild->parent = NULL;
+    }
+    Node *middle = NULL;
+    int middleHeight = 0;
+    int comp = tree->compFunc(node->data, key);
+    if (comp == 0 && equal != NULL)
+    {
+        node->left = NULL;
+        node->right = NULL;
+        *equal = node;
+        *left = leftChild;
+        *leftHeight = childHeight;
+        *right = rightChild;
+        *rightHeight = childHeight;
+    }
+    else if (comp < 0)
+    {
+        splitSubtree(tree, rightChild, childHeight, key, &middle, &middleHeight, equal, right,
+                     rightHeight);
+        *left = joinSubtrees(tree, leftChild, childHeight, node, middle, middleHeight, leftHeight);
+    }
+    else
+    {
+        splitSubtree(tree, leftChild, childHeight, key, left, leftHeight, equal, &middle,
+                     &middleHeight);
+        *right = joinSubtrees(tree, middle, middleHeight, node, rightChild, childHeight,
+                              rightHeight);
+    }
+}
+
+/**
+ * @brief tells the amount of bytes the copy of the data of the given node takes in the arena of
+ * the tree, according to the SizeFunc of the tree
+ * @param tree the tree of the node
+ * @param node the node to check
+ * @return the amount of bytes, 0 if the tree has no arena or no SizeFunc
+ */
+size_t arenaDataSize(RBTree *tree, Node *node)
+{
+    if (tree->sizeFunc == NULL || tree->arenaCopyFunc == NULL || node->data == NULL)
+    {
+        return 0;
+    }
+    return tree->sizeFunc(node->data);
+}
+
+/**
+ * @brief divides the sizes and the accounted memory of a tree that was split between its two
+ * parts. walks only the smaller part, and nothing at all in a tree with order statistics and no
+ * SizeFunc. without a SizeFunc, the arena bytes are divided by the amount of items.
+ * @param tree the part with the smaller items
+ * @param newTree the part with the greater items
+ * @param total the amount of items before the split
+ */
+void divideSplitAccounting(RBTree *tree, RBTree *newTree, int total)
+{
+    if (tree->hasOrderStatistics)
+    {
+        newTree->size = subtreeSizeOf(newTree->root);
+    }
+    else
+    {
+        // both parts are walked together, so the walk ends with the smaller one
+        Node *leftNode = firstNode(tree->root);
+        Node *rightNode = firstNode(newTree->root);
+        int count = 0;
+        while (leftNode != NULL && rightNode != NULL)
+        {
+            leftNode = nextNode(tree, leftNode);
+            rightNode = nextNode(newTree, rightNode);
+            count++;
+        }
+        newTree->size = rightNode == NULL ? count : total - count;
+    }
+    tree->size = total - newTree->size;
+    if (!tree->isIntrusive)
+    {
+        tree->nodeSlab.liveItems -= (size_t) newTree->size;
+        newTree->nodeSlab.liveItems = (size_t) newTree->size;
+    }
+    size_t arenaBytes = tree->keyArena.usedBytes;
+    if (arenaBytes != 0 && tree->sizeFunc == NULL)
+    {
+        newTree->keyArena.usedBytes = (size_t) ((double) arenaBytes * newTree->size / total);
+        tree->keyArena.usedBytes = arenaBytes - newTree->keyArena.usedBytes;
+    }
+    else if (tree->dataBytes != 0 || arenaBytes != 0)
+    {
+        RBTree *smaller = newTree->size < tree->size ? newTree : tree;
+        RBTree *bigger = smaller == tree ? newTree : tree;
+        size_t smallerBytes = 0;
+        size_t smallerArenaBytes = 0;
+        for (Node *curNode = firstNode(smaller->root); curNode != NULL;
+             curNode = nextNode(smaller, curNode))
+        {
+            smallerBytes += ownedDataSize(smaller, curNode);
+            smallerArenaBytes += arenaDataSize(smaller, curNode);
+        }
+        // the bigger part also keeps the bytes of the copies that were removed
+        bigger->dataBytes = tree->dataBytes - smallerBytes;
+        smaller->dataBytes = smallerBytes;
+        bigger->keyArena.usedBytes = arenaBytes - smallerArenaBytes;
+        smaller->keyArena.usedBytes = smallerArenaBytes;
+    }
+}
+
+/**
+ * move all the items that are not smaller than the given item to a new tree. takes O(log n) in a
+ * tree with order statistics and no sizeFunc. otherwise, the smaller part of the tree is walked to
+ * divide the sizes and the memory between the parts, so a split that leaves k of n items in the
+ * tree takes O(log n + min(k, n - k)). the nodes are moved and not copied, so the two trees share
+ * their memory until both are freed. cursors on the tree are no longer valid.
+ * @param tree: the tree to split. keeps the items smaller than key.
+ * @param key: the item to split at (does not have to be in the tree).
+ * @return: a new tree with the same settings, that holds the items not smaller than key. NULL on
+ * failure (or if the tree has an allocator with a reset function), in which case the tree is left
+ * as it was.
+ */
+RBTree *splitRBTree(RBTree *tree, void *key)
+{
+    if (tree == NULL || key == NULL || tree->allocator.reset != NULL)
+    {
+        return NULL;
+    }
+    const Allocator *allocator = tree->allocator.alloc != NULL ? &tree->allocator : NULL;
+    RBTree *newTree = (RBTree *) (allocator != NULL
+                                  ? allocator->alloc(sizeof(RBTree), allocator->context)
+                                  : malloc(sizeof(RBTree)));
+    if (newTree == NULL)
+    {
+        fprintf(stderr, "%s", ERR_MALLOC);
+        return NULL;
+    }
+    *newTree = *tree;
+    newTree->root = NULL;
+    newTree->size = START_SIZE;
+    newTree->dataBytes = 0;
+    newTree->first = NULL;
+    newTree->last = NULL;
+    allocator = allocator != NULL ? &newTree->allocator : NULL;
+    initSlab(&newTree->nodeSlab, tree->nodeSlab.itemSize, tree->nodeSlab.useHugePages, allocator);
+    initArena(&newTree->keyArena, allocator);
+    newTree->nextSharing = tree->nextSharing;
+    tree->nextSharing = newTree;
+    if (tree->root == NULL)
+    {
+        return newTree;
+    }
+    Node *rightFirst = firstNodeAbove(tree, key, 1);
+    Node *leftLast = rightFirst != NULL ? previousNode(tree, rightFirst) : lastNode(tree->root);
+    Node *root = tree->root;
+    int leftHeight, rightHeight;
+    splitSubtree(tree, root, blackHeightOf(root), key, &tree->root, &leftHeight, NULL,
+                 &newTree->root, &rightHeight);
+    if (tree->isThreaded)
+    {
+        newTree->first = rightFirst;
+        newTree->last = rightFirst != NULL ? tree->last : NULL;
+        tree->last = leftLast;
+        if (leftLast != NULL)
+        {
+            linksOf(tree, leftLast)->next = NULL;
+        }
+        else
+        {
+            tree->first = NULL;
+        }
+        if (rightFirst != NULL)
+        {
+            linksOf(tree, rightFirst)->prev = NULL;
+        }
+    }
+    divideSplitAccounting(tree, newTree, tree->size);
+    return newTree;
+}
+
+/**
+ * move all the items of a tree to the end of another tree, whose items are all smaller. takes
+ * O(log n). the nodes are moved and not copied, so the memory of the trees is shared until all of
+ * their nodes are freed. cursors on both trees are no longer valid.
+ * @param left: the tree to add the items to.
+ * @param right: the tree to take the items from. it must have the same settings as left, and
+ * only items greater than those of left. it is freed on success.
+ * @return: 0 on failure (if the settings are not the same, if the items are not in order or if
+ * the trees have an allocator with a reset function), in which case both trees are left as they
+ * were. other on success.
+ */
+int joinRBTree(RBTree *left, RBTree *right)
+{
+    if (left == NULL || right == NULL || left == right || !canShareNodes(left, right))
+    {
+        return FAILURE;
+    }
+    if (left->root != NULL && right->root != NULL
+        && left->compFunc(lastNode(left->root)->data, firstNode(right->root)->data) >= 0)
     {
-        if (forEachNode(node->right, func, args) == FAILURE)
+        return FAILURE;
+    }
+    joinSharingRings(left, right);
+    if (right->root != NULL)
+    {
+        // the smallest node of right goes between the two trees
+        Node *middle = firstNode(right->root);
+        unlinkNode(right, middle);
+        Node *rightFirst = right->first;
+        Node *rightLast = right->last;
+        int height;
+        left->root = joinSubtrees(left, left->root, blackHeightOf(left->root), middle,
+                                  right->root, blackHeightOf(right->root), &height);
+        if (left->isThreaded)
+        {
+            threadNode(left, middle, left->last, rightFirst);
+            if (rightFirst != NULL)
+            {
+                left->last = rightLast;
+            }
+        }
+        left->size += right->size;
+        left->dataBytes += right->dataBytes;
+        left->nodeSlab.liveItems += right->nodeSlab.liveItems;
+        left->keyArena.usedBytes += right->keyArena.usedBytes;
+        right->root = NULL;
+        right->size = START_SIZE;
+        right->dataBytes = 0;
+        right->nodeSlab.liveItems = 0;
+        right->keyArena.usedBytes = 0;
+        right->first = NULL;
+        right->last = NULL;
+    }
+    freeRBTree(right);
+    return SUCCESS;
+}
+
+/**
+ * @brief adds the given subtree to the subtrees that were taken out of a result
+ * @param dropped the subtrees that were taken out so far
+ * @param subtree the root of the subtree to add (may be NULL)
+ */
+void dropSubtree(DroppedNodes *dropped, Node *subtree)
+{
+    if (subtree == NULL)
+    {
+        return;
+    }
+    subtree->parent = NULL;
+    if (dropped->last != NULL)
+    {
+        dropped->last->parent = subtree;
+    }
+    else
+    {
+        dropped->first = subtree;
+    }
+    dropped->last = subtree;
+}
+
+/**
+ * @brief adds the subtrees that were taken out of one part of a result to those of another part
+ * @param dropped the subtrees of one part
+ * @param more the subtrees of the other part
+ */
+void addDroppedNodes(DroppedNodes *dropped, const DroppedNodes *more)
+{
+    if (more->first == NULL)
+    {
+        return;
+    }
+    if (dropped->last != NULL)
+    {
+        dropped->last->parent = more->first;
+    }
+    else
+    {
+        dropped->first = more->first;
+    }
+    dropped->last = more->last;
+}
+
+/**
+ * @brief joins two subtrees into one, when there is no node to put between them
+ * @param tree the tree the nodes belong to
+ * @param left the subtree of the smaller items (may be NULL), with no parent
+ * @param leftHeight the black height of left
+ * @param right the subtree of the greater items (may be NULL), with no parent
+ * @param rightHeight the black height of right
+ * @param height the black height of the joined subtree is put here
+ * @return the root of the joined subtree
+ */
+Node *joinSubtreePair(RBTree *tree, Node *left, int leftHeight, Node *right, int rightHeight,
+                      int *height)
+{
+    if (left == NULL || right == NULL)
+    {
+        *height = left != NULL ? leftHeight : rightHeight;
+        return left != NULL ? left : right;
+    }
+    // the greatest node of left goes between them
+    Node *middle = lastNode(left);
+    Node *greater;
+    int greaterHeight;
+    splitSubtree(tree, left, leftHeight, middle->data, &left, &leftHeight, &middle, &greater,
+                 &greaterHeight);
+    return joinSubtrees(tree, left, leftHeight, middle, right, rightHeight, height);
+}
+
+Node *setOperation(RBTree *tree, int operation, Node *treeRoot, int treeHeight, Node *other,
+                   int otherHeight, int forks, DroppedNodes *dropped, int *height);
+
+/**
+ * @brief runs a set task in the thread that was made for it
+ * @param task the SetTask to run
+ * @return NULL
+ */
+void *runSetTask(void *task)
+{
+    SetTask *setTask = (SetTask *) task;
+    setTask->result = setOperation(&setTask->scratch, setTask->operation, setTask->tree,
+                                   setTask->treeHeight, setTask->other, setTask->otherHeight,
+                                   setTask->forks, &setTask->dropped,
+                                   &setTask->resultHeight);
+    return NULL;
+}
+
+/**
+ * @brief does a set operation on two subtrees by recursion: splits the other subtree by the root
+ * of the first one, does the operation on the two sides and joins the results. takes
+ * O(m log(n / m + 1)) for subtrees of m and n nodes (m <= n). while forks is not 0, the left
+ * side of a big subtree is handed to a thread of its own, and the rest of forks is divided between
+ * the two sides, so no more than forks threads run under this call at once. each thread is made
+ * for its side and joined when the side is done: there are only a few of them per operation, and
+ * each has O(n / forks) work, so a pool would save little over making them.
+ * @param tree a copy of the tree the nodes belong to, that belongs to this thread
+ * @param operation UNION_OPERATION, INTERSECT_OPERATION or DIFFERENCE_OPERATION
+ * @param treeRoot the root of the first subtree (may be NULL), with no parent
+ * @param treeHeight the black height of the first subtree
+ * @param other the root of the other subtree (may be NULL), with no parent
+ * @param otherHeight the black height of the other subtree
+ * @param forks how many more threads the recursion may make
+ * @param dropped the nodes that are left out of the result are added here
+ * @param height the black height of the result is put here
+ * @return the root of the result. a node that is in both subtrees is kept from the first one.
+ */
+Node *setOperation(RBTree *tree, int operation, Node *treeRoot, int treeHeight, Node *other,
+                   int otherHeight, int forks, DroppedNodes *dropped, int *height)
+{
+    if (treeRoot == NULL || other == NULL)
+    {
+        int keepsTree = operation != INTERSECT_OPERATION;
+        int keepsOther = operation == UNION_OPERATION;
+        dropSubtree(dropped, keepsTree ? NULL : treeRoot);
+        dropSubtree(dropped, keepsOther ? NULL : other);
+        Node *result = keepsTree && treeRoot != NULL ? treeRoot : keepsOther ? other : NULL;
+        *height = result == NULL ? 0 : result == treeRoot ? treeHeight : otherHeight;
+        return result;
+    }
+    Node *middle = treeRoot;
+    int childHeight = treeHeight - (middle->color == BLACK);
+    Node *treeLeft = middle->left;
+    Node *treeRight = middle->right;
+    if (treeLeft != NULL)
+    {
+        treeLeft->parent = NULL;
+    }
+    if (treeRight != NULL)
+    {
+        treeRight->parent = NULL;
+    }
+    middle->left = NULL;
+    middle->right = NULL;
+    Node *otherLeft, *equal, *otherRight;
+    int otherLeftHeight, otherRightHeight;
+    splitSubtree(tree, other, otherHeight, middle->data, &otherLeft, &otherLeftHeight, &equal,
+                 &otherRight, &otherRightHeight);
+    Node *left, *right;
+    int leftHeight, rightHeight;
+    int isForked = 0;
+    int rightForks = forks;
+#ifndef RBTREE_NO_THREADS
+    SetTask leftTask;
+    pthread_t leftThread;
+    if (forks > 0 && childHeight >= MIN_PARALLEL_HEIGHT)
+    {
+        leftTask.scratch = *tree;
+        leftTask.operation = operation;
+        leftTask.tree = treeLeft;
+        leftTask.treeHeight = childHeight;
+        leftTask.other = otherLeft;
+        leftTask.otherHeight = otherLeftHeight;
+        leftTask.forks = (forks - 1) / 2;
+        leftTask.dropped.first = NULL;
+        leftTask.dropped.last = NULL;
+        // if no thread can be made, the left side is done in this one
+        isForked = pthread_create(&leftThread, NULL, runSetTask, &leftTask) == 0;
+        if (isForked)
+        {
+            rightForks = forks - 1 - leftTask.forks;
+        }
+    }
+#endif
+    if (!isForked)
+    {
+        // the left side is done before the right one starts, so each may make all the threads
+        left = setOperation(tree, operation, treeLeft, childHeight, otherLeft, otherLeftHeight,
+                            forks, dropped, &leftHeight);
+    }
+    right = setOperation(tree, operation, treeRight, childHeight, otherRight, otherRightHeight,
+                         rightForks, dropped, &rightHeight);
+#ifndef RBTREE_NO_THREADS
+    if (isForked)
+    {
+        pthread_join(leftThread, NULL);
+        left = leftTask.result;
+        leftHeight = leftTask.resultHeight;
+        addDroppedNodes(dropped, &leftTask.dropped);
+    }
+#endif
+    int keepsMiddle = operation == DIFFERENCE_OPERATION ? equal == NULL
+                      : operation == INTERSECT_OPERATION ? equal != NULL : 1;
+    dropSubtree(dropped, equal);
+    if (!keepsMiddle)
+    {
+        dropSubtree(dropped, middle);
+        return joinSubtreePair(tree, left, leftHeight, right, rightHeight, height);
+    }
+    return joinSubtrees(tree, left, leftHeight, middle, right, rightHeight, height);
+}
+
+/**
+ * @brief releases the nodes of the given subtree, and frees their items like removeNode does
+ * @param tree the tree the nodes were taken out of
+ * @param node the root of the subtree (may be NULL)
+ */
+void releaseSubtree(RBTree *tree, Node *node)
+{
+    if (node == NULL)
+    {
+        return;
+    }
+    releaseSubtree(tree, node->left);
+    releaseSubtree(tree, node->right);
+    tree->size -= 1;
+    tree->dataBytes -= ownedDataSize(tree, node);
+    freeValueOf(tree, node);
+    void *data = node->data;
+    int isInline = tree->inlineKeySize != 0 && data == inlineKeyBuffer(tree, node);
+    if (!tree->isIntrusive)
+    {
+        slabFree(&tree->nodeSlab, node);
+    }
+    if (tree->freeFunc != NULL && tree->arenaCopyFunc == NULL && !isInline)
+    {
+        tree->freeFunc(data);
+    }
+}
+
+/**
+ * @brief links the nodes of a threaded tree in their order again, after its structure was made
+ * anew. takes O(n).
+ * @param tree the tree to link
+ */
+void rethreadTree(RBTree *tree)
+{
+    RBTree structure = *tree;
+    structure.isThreaded = 0; // so nextNode follows the structure and not the old links
+    tree->first = NULL;
+    tree->last = NULL;
+    for (Node *curNode = firstNode(tree->root); curNode != NULL;
+         curNode = nextNode(&structure, curNode))
+    {
+        threadNode(tree, curNode, tree->last, NULL);
+    }
+}
+
+/**
+ * @brief does a set operation on two trees, and puts the result in the first one
+ * @param tree the first tree, that gets the result
+ * @param other the other tree, that is freed
+ * @param operation UNION_OPERATION, INTERSECT_OPERATION or DIFFERENCE_OPERATION
+ * @param maxThreads the most threads to run at once (1 or less for only the calling one)
+ * @return 1 on success, 0 if the trees do not have the same settings
+ */
+int setOperationRBTree(RBTree *tree, RBTree *other, int operation, int maxThreads)
+{
+    if (tree == NULL || other == NULL || tree == other || !canShareNodes(tree, other)
+        || tree->isMultiset)
+    {
+        return FAILURE;
+    }
+    joinSharingRings(tree, other);
+    int forks = maxThreads > 1 ? maxThreads - 1 : 0; // the calling thread is one of them
+    RBTree scratch = *tree;
+    DroppedNodes dropped = {NULL, NULL};
+    int height;
+    tree->root = setOperation(&scratch, operation, tree->root, blackHeightOf(tree->root),
+                              other->root, blackHeightOf(other->root), forks, &dropped,
+                              &height);
+    if (tree->root != NULL)
+    {
+        tree->root->color = BLACK;
+    }
+    // all the nodes of both trees are now in tree, until the dropped ones are released
+    tree->size += other->size;
+    tree->dataBytes += other->dataBytes;
+    tree->nodeSlab.liveItems += other->nodeSlab.liveItems;
+    tree->keyArena.usedBytes += other->keyArena.usedBytes;
+    other->root = NULL;
+    other->size = START_SIZE;
+    other->dataBytes = 0;
+    other->nodeSlab.liveItems = 0;
+    other->keyArena.usedBytes = 0;
+    other->first = NULL;
+    other->last = NULL;
+    for (Node *subtree = dropped.first; subtree != NULL;)
+    {
+        Node *next = subtree->parent;
+        releaseSubtree(tree, subtree);
+        subtree = next;
+    }
+    if (tree->isThreaded)
+    {
+        rethreadTree(tree);
+    }
+    freeRBTree(other);
+    return SUCCESS;
+}
+
+/**
+ * move the items of another tree into a tree. takes O(m log(n / m + 1)) for trees of m and n
+ * items (m <= n), and splits the work so that no more than maxThreads threads (the calling one
+ * among them) run at once. the nodes are moved and not copied, so the memory of the trees is
+ * shared until all of their nodes are freed. the CompareFunc (and the aggregate functions) are
+ * called from several threads at once. in a threaded tree, the links are made anew, which takes
+ * O(n + m). the threads are POSIX threads, made for the part of the work they do and joined when
+ * it is done (there are at most maxThreads - 1 of them, so no pool is kept), and the program is
+ * linked with -pthread (or RBTree.c is compiled with RBTREE_NO_THREADS, to do all the work in the
+ * calling thread).
+ * @param tree: the tree to add the items to.
+ * @param other: the tree to take the items from. it must have the same settings as tree. it is
+ * freed on success, and so are its items that tree already has an equal item to.
+ * @param maxThreads: the most threads to run at once, the calling one among them (1 or less to use
+ * only the calling thread).
+ * @return: 0 on failure (if the settings are not the same, if the trees are multisets or if they
+ * have an allocator with a reset function), in which case both trees are left as they were. other on success.
+ */
+int unionRBTree(RBTree *tree, RBTree *other, int maxThreads)
+{
+    return setOperationRBTree(tree, other, UNION_OPERATION, maxThreads);
+}
+
+/**
+ * keep in a tree only the items that another tree has an equal item to. takes and works like
+ * unionRBTree.
+ * @param tree: the tree to keep the items in. the items it does not keep are freed.
+ * @param other: the tree to compare with. it must have the same settings as tree. it is freed on
+ * success, with all of its items.
+ * @param maxThreads: the most threads to run at once, the calling one among them (1 or less to use
+ * only the calling thread).
+ * @return: 0 on failure (if the settings are not the same, if the trees are multisets or if they
+ * have an allocator with a reset function), in which case both trees are left as they were. other on success.
+ */
+int intersectRBTree(RBTree *tree, RBTree *other, int maxThreads)
+{
+    return setOperationRBTree(tree, other, INTERSECT_OPERATION, maxThreads);
+}
+
+/**
+ * remove from a tree all the items that another tree has an equal item to. takes and works like
+ * unionRBTree.
+ * @param tree: the tree to remove the items from. the removed items are freed.
+ * @param other: the tree with the items to remove. it must have the same settings as tree. it is
+ * freed on success, with all of its items.
+ * @param maxThreads: the most threads to run at once, the calling one among them (1 or less to use
+ * only the calling thread).
+ * @return: 0 on failure (if the settings are not the same, if the trees are multisets or if they
+ * have an allocator with a reset function), in which case both trees are left as they were. other on success.
+ */
+int differenceRBTree(RBTree *tree, RBTree *other, int maxThreads)
+{
+    return setOperationRBTree(tree, other, DIFFERENCE_OPERATION, maxThreads);
+}
+
+/**
+ * move the items of many trees into the first of them, by uniting them in pairs, so every item
+ * takes part in O(log k) unions of k trees.
+ * @param trees: the trees to unite. they must all have the same settings. the first one gets the
+ * items, and all the others are freed on success (and set to NULL in trees).
+ * @param n: the amount of trees.
+ * @param maxThreads: the most threads every union uses (1 or less to use only the calling thread).
+ * @return: 0 on failure (if the settings are not the same, if the trees are multisets or if a
+ * tree is given twice), in which case all the trees are left as they were. other on success. if
+ * a union fails after these checks, the unions that were done are kept, and 0 is returned with
+ * the trees that are left in trees.
+ */
+int unionManyRBTree(RBTree **trees, int n, int maxThreads)
+{
+    if (trees == NULL || n < 1 || trees[0] == NULL || trees[0]->isMultiset)
+    {
+        return FAILURE;
+    }
+    for (int i = 1; i < n; i++)
+    {
+        if (trees[i] == NULL || !canShareNodes(trees[0], trees[i]))
         {
             return FAILURE;
         }
+        for (int j = 0; j < i; j++)
+        {
+            if (trees[j] == trees[i])
+            {
+                return FAILURE;
+            }
+        }
+    }
+    for (int step = 1; step < n; step *= 2)
+    {
+        for (int i = 0; i + step < n; i += 2 * step)
+        {
+            // the checks above are the ones a union makes, so it is not expected to fail
+            if (!unionRBTree(trees[i], trees[i + step], maxThreads))
+            {
+                return FAILURE;
+            }
+            trees[i + step] = NULL;
+        }
     }
     return SUCCESS;
 }
 
 /**
- * Activate a function on each item of the tree. the order is an ascending order. if one of the activations of the
- * function returns 0, the process stops.
- * @param tree: the tree with all the items.
- * @param func: the function to activate on all items.
- * @param args: more optional arguments to the function (may be null if the given function support it).
+ * @brief moves the nodes a clone task made, and the memory they lie in, to the tree it was made
+ * for
+ * @param clone the tree to move the nodes to
+ * @param task the task that is done
+ */
+void adoptCloneTask(RBTree *clone, CloneTask *task)
+{
+    clone->size += task->scratch.size;
+    clone->dataBytes += task->scratch.dataBytes;
+    clone->nodeSlab.liveItems += task->scratch.nodeSlab.liveItems;
+    clone->keyArena.usedBytes += task->scratch.keyArena.usedBytes;
+    slabAdopt(&clone->nodeSlab, &task->scratch.nodeSlab);
+    arenaAdopt(&clone->keyArena, &task->scratch.keyArena);
+}
+
+int cloneSubtree(RBTree *clone, CopyFunc copyFunc, Node *node, int height, int forks,
+                 size_t share, Node **subtree);
+
+/**
+ * @brief runs a clone task in the thread that was made for it
+ * @param task the CloneTask to run
+ * @return NULL
+ */
+void *runCloneTask(void *task)
+{
+    CloneTask *cloneTask = (CloneTask *) task;
+    cloneTask->isCloned = slabReserve(&cloneTask->scratch.nodeSlab, cloneTask->share)
+                          && cloneSubtree(&cloneTask->scratch, cloneTask->copyFunc,
+                                          cloneTask->node, cloneTask->height,
+                                          cloneTask->forks, cloneTask->share,
+                                          &cloneTask->result);
+    return NULL;
+}
+
+/**
+ * @brief copies a subtree by recursion, from every node down to its children, so the copies are
+ * allocated in the order of a walk over the subtree. the threads are made like in setOperation, so
+ * no more than forks threads run under this call at once.
+ * @param clone the new tree (or a copy of it that belongs to this thread)
+ * @param copyFunc the function to copy the items with (may be NULL)
+ * @param node the root of the subtree to copy (may be NULL)
+ * @param height the black height of the subtree
+ * @param forks how many more threads the recursion may make
+ * @param share the amount of nodes a thread is expected to copy, to reserve room for
+ * @param subtree the root of the copy is put here (NULL for an empty subtree)
+ * @return 1 on success, 0 if a copy failed (the nodes that were made are left linked)
+ */
+int cloneSubtree(RBTree *clone, CopyFunc copyFunc, Node *node, int height, int forks,
+                 size_t share, Node **subtree)
+{
+    *subtree = NULL;
+    if (node == NULL)
+    {
+        return SUCCESS;
+    }
+    void *data = node->data;
+    if (copyFunc != NULL && clone->inlineKeySize == 0 && clone->arenaCopyFunc == NULL)
+    {
+        data = copyFunc(data);
+        if (data == NULL)
+        {
+            return FAILURE;
+        }
+    }
+    Node *copy = makeNewNode(clone, data);
+    if (copy == NULL)
+    {
+        if (data != node->data && clone->freeFunc != NULL)
+        {
+            clone->freeFunc(data);
+        }
+        return FAILURE;
+    }
+    copy->color = node->color;
+    if (clone->isMultiset)
+    {
+        *countOf(clone, copy) = *countOf(clone, node);
+    }
+    if (clone->isMap)
+    {
+        *valueOf(clone, copy) = *valueOf(clone, node);
+    }
+    *subtree = copy;
+    clone->size += 1;
+    clone->dataBytes += ownedDataSize(clone, copy);
+    int childHeight = height - (node->color == BLACK);
+    int leftCloned = SUCCESS;
+    int isForked = 0;
+    int rightForks = forks;
+#ifndef RBTREE_NO_THREADS
+    CloneTask leftTask;
+    pthread_t leftThread;
+    if (forks > 0 && childHeight >= MIN_PARALLEL_HEIGHT)
+    {
+        leftTask.scratch = *clone;
+        leftTask.scratch.size = START_SIZE;
+        leftTask.scratch.dataBytes = 0;
+        initSlab(&leftTask.scratch.nodeSlab, clone->nodeSlab.itemSize,
+                 clone->nodeSlab.useHugePages, NULL);
+        initArena(&leftTask.scratch.keyArena, NULL);
+        leftTask.copyFunc = copyFunc;
+        leftTask.node = node->left;
+        leftTask.height = childHeight;
+        leftTask.forks = (forks - 1) / 2;
+        leftTask.share = share;
+        leftTask.result = NULL;
+        // if no thread can be made, the left side is done in this one
+        isForked = pthread_create(&leftThread, NULL, runCloneTask, &leftTask) == 0;
+        if (isForked)
+        {
+            rightForks = forks - 1 - leftTask.forks;
+        }
+    }
+#endif
+    if (!isForked)
+    {
+        leftCloned = cloneSubtree(clone, copyFunc, node->left, childHeight, forks, share,
+                                  &copy->left);
+    }
+    int rightCloned = cloneSubtree(clone, copyFunc, node->right, childHeight, rightForks, share,
+                                   &copy->right);
+#ifndef RBTREE_NO_THREADS
+    if (isForked)
+    {
+        pthread_join(leftThread, NULL);
+        adoptCloneTask(clone, &leftTask);
+        copy->left = leftTask.result;
+        leftCloned = leftTask.isCloned;
+    }
+#endif
+    if (copy->left != NULL)
+    {
+        copy->left->parent = copy;
+    }
+    if (copy->right != NULL)
+    {
+        copy->right->parent = copy;
+    }
+    if (clone->isAugmented)
+    {
+        updateNode(clone, copy);
+    }
+    return leftCloned && rightCloned ? SUCCESS : FAILURE;
+}
+
+/**
+ * constructs a copy of a tree with the same settings, in O(n) and with no calls to the
+ * CompareFunc: the nodes are copied with their colors, and not added again. the nodes of the copy
+ * lie one after the other in its memory. the work is split so that no more than maxThreads threads
+ * (the calling one among them) run at once, and they call copyFunc (and the score and aggregate
+ * functions) at once. the threads are made and joined like in unionRBTree. a tree with an
+ * allocator is copied only by the calling thread, since the allocator may not be safe for threads.
+ * @param tree: the tree to copy.
+ * @param copyFunc: the function to copy the items with. may be NULL, in which case the copy holds
+ * the same items and does not free them. ignored by a tree that keeps copies of its items (inside
+ * its nodes or in its arena), which copies them like it does when they are added.
+ * @param maxThreads: the most threads to run at once, the calling one among them (1 or less to use
+ * only the calling thread).
+ * @return: the copy, or NULL on failure (or if the tree is intrusive, or has an allocator with a
+ * reset function).
+ */
+RBTree *cloneRBTree(RBTree *tree, CopyFunc copyFunc, int maxThreads)
+{
+    if (tree == NULL || tree->isIntrusive || tree->allocator.reset != NULL)
+    {
+        return NULL;
+    }
+    int copiesItems = tree->inlineKeySize != 0 || tree->arenaCopyFunc != NULL;
+    RBTreeOptions options = {0};
+    options.useHugePages = tree->nodeSlab.useHugePages;
+    options.inlineKeySize = tree->inlineKeySize;
+    options.inlineCopyFunc = tree->inlineCopyFunc;
+    options.arenaCopyFunc = tree->arenaCopyFunc;
+    options.allocator = tree->allocator.alloc != NULL ? &tree->allocator : NULL;
+    options.sizeFunc = tree->sizeFunc;
+    options.hasOrderStatistics = tree->hasOrderStatistics;
+    options.isThreaded = tree->isThreaded;
+    options.maxScoreFunc = tree->maxScoreFunc;
+    options.aggregateSize = tree->aggregateSize;
+    options.aggregateItemFunc = tree->aggregateItemFunc;
+    options.aggregateCombineFunc = tree->aggregateCombineFunc;
+    options.isMultiset = tree->isMultiset;
+    options.isMap = tree->isMap;
+    // without a copy, the items still belong to the tree
+    RBTree *clone = newRBTreeWithOptions(tree->compFunc,
+                                         copiesItems || copyFunc != NULL ? tree->freeFunc : NULL,
+                                         &options);
+    if (clone == NULL)
+    {
+        return NULL;
+    }
+    int height = blackHeightOf(tree->root);
+    // the calling thread is one of the threads
+    int forks = options.allocator == NULL && maxThreads > 1 ? maxThreads - 1 : 0;
+    // every thread copies about the same amount of nodes
+    size_t share = (size_t) tree->size / (size_t) (forks + 1);
+    if (slabReserve(&clone->nodeSlab, share) == FAILURE
+        || cloneSubtree(clone, copyFunc, tree->root, height, forks, share,
+                        &clone->root) == FAILURE)
+    {
+        freeRBTree(clone);
+        return NULL;
+    }
+    if (clone->isThreaded)
+    {
+        rethreadTree(clone);
+    }
+    return clone;
+}
+
+/**
+ * tell how much memory the tree uses. takes O(1).
+ * @param tree: the tree to check.
+ * @param memory: where to put the amounts.
  * @return: 0 on failure, other on success.
  */
-int forEachRBTree(RBTree *tree, forEachFunc func, void *args)
+int getRBTreeMemory(const RBTree *tree, RBTreeMemory *memory)
 {
-    if (tree == NULL || func == NULL)
+    if (tree == NULL || memory == NULL)
     {
         return FAILURE;
     }
-    return forEachNode(tree->root, func, args);
+    const Slab *slab = &tree->nodeSlab;
+    size_t liveNodeBytes = slab->liveItems * slab->itemSize;
+    memory->treeBytes = sizeof(RBTree);
+    // the nodes of an intrusive tree are a part of its items, and don't come from the slab
+    memory->nodeBytes = tree->isIntrusive ? (size_t) tree->size * sizeof(Node) : liveNodeBytes;
+    memory->arenaBytes = tree->keyArena.usedBytes;
+    // after a split, the nodes and copies of a tree may lie in chunks that another tree holds
+    memory->slackBytes = (slab->chunkBytes > liveNodeBytes ? slab->chunkBytes - liveNodeBytes : 0)
+                         + (tree->keyArena.chunkBytes > tree->keyArena.usedBytes
+                            ? tree->keyArena.chunkBytes - tree->keyArena.usedBytes : 0);
+    memory->dataBytes = tree->dataBytes;
+    memory->totalBytes = memory->treeBytes + memory->nodeBytes + memory->arenaBytes
+                         + memory->slackBytes + memory->dataBytes;
+    return SUCCESS;
 }
 
 /**
@@ -458,10 +3567,33 @@ void freeRBTree(RBTree *tree)
 {
     if (tree != NULL)
     {
-        if (tree->root != NULL)
+        // the copies in the arena are freed all together with it
+        int hasValuesToFree = tree->isMap && tree->valueFreeFunc != NULL;
+        if (tree->root != NULL
+            && ((tree->freeFunc != NULL && tree->arenaCopyFunc == NULL) || hasValuesToFree))
+        {
+            freeNodes(tree, tree->root);
+        }
+        Allocator allocator = tree->allocator;
+        if (allocator.reset != NULL)
+        {
+            // the allocator releases the nodes, the arena and the tree itself at once
+            allocator.reset(allocator.context);
+            return;
+        }
+        if (tree->nextSharing != tree)
+        {
+            leaveSharingRing(tree);
+        }
+        freeSlab(&tree->nodeSlab);
+        freeArena(&tree->keyArena);
+        if (allocator.alloc != NULL)
+        {
+            allocator.free(tree, sizeof(RBTree), allocator.context);
+        }
+        else
         {
-            freeNodes(tree->root, tree->freeFunc);
+            free(tree);
         }
-        free(tree);
     }
 }
\ No newline at end of file
@@ -5,6 +5,9 @@
 #ifndef RBTREE_RBTREE_H
 #define RBTREE_RBTREE_H
 
+#include "Slab.h"
+#include "Arena.h"
+
 // a color of a Node.
 typedef enum Color
 {
@@ -29,22 +32,117 @@ typedef int (*forEachFunc)(const void *object, void *args);
 /**
  * a function to free a data item
  * @object: a pointer to an item of the tree.
+ * may be NULL, if the tree does not own its items.
  */
 typedef void (*FreeFunc)(void *data);
 
+/**
+ * a function to apply on all tree items of a multiset, with the amount of times they were added.
+ * @object: a pointer to an item of the tree.
+ * @count: the amount of times the item is in the tree.
+ * @args: pointer to other arguments for the function.
+ * @return: 0 on failure, other on success.
+ */
+typedef int (*forEachCountFunc)(const void *object, int count, void *args);
+
+/**
+ * a function to apply on all the keys of a map, with their values.
+ * @key: a pointer to a key of the tree.
+ * @value: the value of the key (may be changed in place).
+ * @args: pointer to other arguments for the function.
+ * @return: 0 on failure, other on success.
+ */
+typedef int (*forEachPairFunc)(const void *key, void *value, void *args);
+
+/**
+ * a function to copy a data item, for cloning a tree.
+ * @object: a pointer to an item of the tree.
+ * @return: the copy (freed with the FreeFunc of the tree), NULL on failure.
+ */
+typedef void *(*CopyFunc)(const void *data);
+
+/**
+ * a function to tell the size of a data item, for the memory accounting of the tree.
+ * @object: a pointer to an item of the tree.
+ * @return: the amount of bytes the item owns.
+ */
+typedef size_t (*SizeFunc)(const void *data);
+
+/**
+ * a function to copy an item into a tree that keeps its items inside its nodes.
+ * @data: the item to copy.
+ * @buffer: room for the copy inside the node.
+ * @bufferSize: the size of the buffer in bytes.
+ * @return: the buffer, if the copy fits in it. otherwise, a copy that was allocated outside of
+ * the node (and is freed with the FreeFunc of the tree). NULL on failure.
+ */
+typedef void *(*InlineCopyFunc)(const void *data, void *buffer, size_t bufferSize);
+
+/**
+ * a function to copy an item into the arena of a tree that keeps its items there.
+ * @data: the item to copy.
+ * @arena: the arena of the tree, to allocate the copy from.
+ * @return: the copy, NULL on failure.
+ */
+typedef void *(*ArenaCopyFunc)(const void *data, Arena *arena);
+
+/**
+ * a function to score an item, for a tree that keeps the item with the greatest score.
+ * @object: a pointer to an item of the tree.
+ * @return: the score of the item. it must not change while the item is in the tree.
+ */
+typedef double (*ScoreFunc)(const void *data);
+
+/**
+ * a function to make the aggregate of a single item, for a tree that keeps an aggregate of every
+ * subtree.
+ * @aggregate: where to put the aggregate (aggregateSize bytes).
+ * @data: the item.
+ */
+typedef void (*AggregateItemFunc)(void *aggregate, const void *data);
+
+/**
+ * a function to combine the aggregates of two runs of items, where the left run comes right
+ * before the right run in the order of the tree. it must be associative.
+ * @result: where to put the aggregate of both runs. may be the same as left or right.
+ * @left, @right: the aggregates of the two runs.
+ */
+typedef void (*AggregateCombineFunc)(void *result, const void *left, const void *right);
+
 /*
  * a node of the tree.
+ * subtreeSize: the amount of items in the subtree of the node, kept only by a tree with order
+ * statistics.
  */
 typedef struct Node
 {
 	struct Node *parent, *left, *right;
 	Color color;
+	int subtreeSize;
 	void *data;
 
 } Node;
 
 /**
  * represents the tree
+ * the nodes are allocated from nodeSlab, and released all together when the tree is freed. an
+ * intrusive tree uses the Node that every item holds nodeOffset bytes from its start instead.
+ * when inlineKeySize is not 0, every node has inlineKeySize more bytes right after it, where
+ * inlineCopyFunc puts a copy of its item.
+ * when arenaCopyFunc is not NULL, the items are copies that it made in keyArena.
+ * when allocator.alloc is not NULL, all the memory of the tree comes from allocator.
+ * dataBytes sums sizeFunc over the items that are not kept inside the nodes or the arena.
+ * isAugmented tells whether the nodes keep values that depend on their subtrees (like
+ * subtreeSize, when hasOrderStatistics is set).
+ * a threaded tree keeps links to the previous and the next node right after every node (at
+ * linksOffset), and its first and last nodes. when maxScoreFunc is not NULL, every node keeps
+ * the item with the greatest score in its subtree at maxScoreOffset. when aggregateSize is not 0,
+ * every node keeps the aggregate of its subtree at aggregateOffset. a multiset keeps the amount
+ * of times the item of every node was added at countOffset, and its size counts every distinct
+ * item once. a map keeps the value of the key of every node at valueOffset, and frees it with
+ * valueFreeFunc. the room for an item inside a node starts at inlineKeyOffset.
+ * trees whose nodes came from each other (by splitRBTree and joinRBTree) are linked in a ring by
+ * nextSharing, and the chunks of their nodes and arenas are freed with the last of them.
  */
 typedef struct RBTree
 {
@@ -52,8 +150,139 @@ typedef struct RBTree
 	CompareFunc compFunc;
 	FreeFunc freeFunc;
 	int size;
+	Slab nodeSlab;
+	int isIntrusive;
+	size_t nodeOffset;
+	size_t inlineKeySize;
+	InlineCopyFunc inlineCopyFunc;
+	Arena keyArena;
+	ArenaCopyFunc arenaCopyFunc;
+	Allocator allocator;
+	SizeFunc sizeFunc;
+	size_t dataBytes;
+	int hasOrderStatistics;
+	int isAugmented;
+	int isThreaded;
+	size_t linksOffset;
+	size_t inlineKeyOffset;
+	Node *first, *last;
+	ScoreFunc maxScoreFunc;
+	size_t maxScoreOffset;
+	size_t aggregateSize;
+	AggregateItemFunc aggregateItemFunc;
+	AggregateCombineFunc aggregateCombineFunc;
+	size_t aggregateOffset;
+	int isMultiset;
+	size_t countOffset;
+	int isMap;
+	size_t valueOffset;
+	FreeFunc valueFreeFunc;
+	struct RBTree *nextSharing;
 } RBTree;
 
+/**
+ * a position in a tree, for walking over it without a callback.
+ * node is the current node, NULL once the cursor went past the first or the last item. adding
+ * items to the tree keeps the cursor valid, and so does removing items other than the current one.
+ */
+typedef struct RBTreeCursor
+{
+	RBTree *tree;
+	Node *node;
+} RBTreeCursor;
+
+/**
+ * optional settings of a tree. a zeroed struct gives the settings of newRBTree.
+ * useHugePages: other than 0 to allocate the nodes from huge pages when the system has them.
+ * isIntrusive: other than 0 if every item embeds its own Node, so the tree allocates no nodes.
+ * the item is kept right next to its node, so reaching it during a search costs no extra cache
+ * miss. the embedded Node belongs to the tree while the item is in it, and freeFunc frees the
+ * whole item together with it.
+ * nodeOffset: for an intrusive tree, the offset of the Node inside every item, e.g.
+ * offsetof(struct MyRecord, node).
+ * inlineKeySize: when not 0, the tree keeps a copy of every item (made by inlineCopyFunc) inside
+ * its node, so a search reads a single cache line per level. the caller keeps owning the items
+ * that it adds, and only the copies that did not fit in the node are freed with the FreeFunc.
+ * can not be used together with isIntrusive.
+ * inlineCopyFunc: the function that copies the items into the nodes, e.g. stringInlineCopy.
+ * arenaCopyFunc: when not NULL, the tree keeps a copy of every item (made by this function, e.g.
+ * stringArenaCopy) in an arena of its own. the copies lie next to each other, and the whole arena
+ * is released at once when the tree is freed, with no FreeFunc calls. the caller keeps owning the
+ * items that it adds, and an item that is already in the tree is not copied at all. can not be
+ * used together with isIntrusive or inlineKeySize.
+ * allocator: when not NULL, the tree header and the chunks of its nodes and of its arena are
+ * allocated with it instead of malloc (and without huge pages). if it has a reset function,
+ * freeRBTree calls it instead of freeing the memory of the tree piece by piece, so it should be
+ * an allocator that is dedicated to this tree.
+ * sizeFunc: may be NULL. tells the size of the items, so the memory they own is accounted for.
+ * hasOrderStatistics: other than 0 to keep the size of every subtree in its root, which makes
+ * rankRBTree, selectRBTree, countRangeRBTree and sampleRBTree take O(log n).
+ * isThreaded: other than 0 to link every node to the nodes before and after it, so walking over
+ * the tree (with forEachRBTree, a cursor or a range) follows a list instead of climbing the tree,
+ * and minRBTree and maxRBTree take O(1). costs two pointers per node. can not be used together
+ * with isIntrusive.
+ * maxScoreFunc: when not NULL, every node keeps the item with the greatest score in its subtree,
+ * so maxScoreRBTree takes O(1). the score of every item is taken once, when it is added. costs
+ * two doubles and a pointer per node. can not be used together with isIntrusive.
+ * aggregateSize: when not 0, every node keeps an aggregate of this size of the items in its
+ * subtree (like their sum, their minimum or their count), so aggregateRBTree takes O(1) and
+ * rangeAggregateRBTree takes O(log n). aggregateItemFunc makes the aggregate of a single item,
+ * and aggregateCombineFunc combines the aggregates of two runs of items. both are called O(log n)
+ * times on every change of the tree. can not be used together with isIntrusive.
+ * isMultiset: other than 0 to count the items that are added more than once, instead of
+ * rejecting them. adding an item that is already in the tree takes a single search, and only
+ * counts it once more (see addToRBTree), and removing it counts it once less. the counts are
+ * given by countRBTree, forEachCountRBTree and forEachInRangeCountRBTree, while all the other
+ * functions (like the order statistics and the aggregates) see every distinct item once. costs an
+ * int per node. can not be used together with isIntrusive.
+ * isMap: other than 0 to keep a value with every item, so the items are the keys of a map. the
+ * CompareFunc compares only the keys, and the values are set with putRBTree and read with
+ * getRBTree and forEachPairRBTree. the FreeFunc of the tree frees the keys, and valueFreeFunc (may
+ * be NULL) frees the values, once their keys are removed or the tree is freed. costs a pointer per
+ * node. can not be used together with isIntrusive or isMultiset.
+ */
+typedef struct RBTreeOptions
+{
+	int useHugePages;
+	int isIntrusive;
+	size_t nodeOffset;
+	size_t inlineKeySize;
+	InlineCopyFunc inlineCopyFunc;
+	ArenaCopyFunc arenaCopyFunc;
+	const Allocator *allocator;
+	SizeFunc sizeFunc;
+	int hasOrderStatistics;
+	int isThreaded;
+	ScoreFunc maxScoreFunc;
+	size_t aggregateSize;
+	AggregateItemFunc aggregateItemFunc;
+	AggregateCombineFunc aggregateCombineFunc;
+	int isMultiset;
+	int isMap;
+	FreeFunc valueFreeFunc;
+} RBTreeOptions;
+
+/**
+ * the memory a tree uses, in bytes.
+ * treeBytes: the RBTree itself.
+ * nodeBytes: the nodes in the tree (with the room for the items inside them, if there is such).
+ * arenaBytes: the copies of the items in the arena of the tree.
+ * slackBytes: memory the tree allocated and does not use: the free parts of its chunks, their
+ * headers and the nodes that wait for reuse. trees that share their memory (after splitRBTree or
+ * joinRBTree) count only the chunks that they hold.
+ * dataBytes: the memory the items own, as told by the SizeFunc of the tree (0 without one).
+ * totalBytes: the sum of all of the above.
+ */
+typedef struct RBTreeMemory
+{
+	size_t treeBytes;
+	size_t nodeBytes;
+	size_t arenaBytes;
+	size_t slackBytes;
+	size_t dataBytes;
+	size_t totalBytes;
+} RBTreeMemory;
+
 /**
  * constructs a new RBTree with the given CompareFunc.
  * comp: a function two compare two variables.
@@ -61,13 +290,102 @@ typedef struct RBTree
 RBTree *newRBTree(CompareFunc compFunc, FreeFunc freeFunc); // implement it in RBTree.c
 
 /**
- * add an item to the tree
+ * constructs a new RBTree with the given CompareFunc and settings.
+ * @param compFunc: a function two compare two variables.
+ * @param freeFunc: a function to free the items of the tree (may be NULL).
+ * @param options: the settings of the tree (may be NULL for the default ones).
+ * @return: the new tree, or NULL on failure (or if the settings do not fit together).
+ */
+RBTree *newRBTreeWithOptions(CompareFunc compFunc, FreeFunc freeFunc, const RBTreeOptions *options);
+
+/**
+ * constructs a new RBTree out of items that are already sorted, in O(n) and with no calls to the
+ * CompareFunc (other than for checking the order, when asked to).
+ * @param items: the items, in an ascending order and with no duplicates.
+ * @param n: the amount of items.
+ * @param compFunc: a function two compare two variables.
+ * @param freeFunc: a function to free the items of the tree (may be NULL).
+ * @param options: the settings of the tree (may be NULL for the default ones).
+ * @param verifyOrder: other than 0 to make sure the items are sorted, with n - 1 comparisons.
+ * @return: the new tree, or NULL on failure (or if the items are not sorted). on failure, the
+ * caller keeps owning the items.
+ */
+RBTree *buildRBTreeFromSorted(void **items, int n, CompareFunc compFunc, FreeFunc freeFunc,
+                              const RBTreeOptions *options, int verifyOrder);
+
+/**
+ * constructs a copy of a tree with the same settings, in O(n) and with no calls to the
+ * CompareFunc: the nodes are copied with their colors, and not added again. the nodes of the copy
+ * lie one after the other in its memory. the work is split so that no more than maxThreads threads
+ * (the calling one among them) run at once, and they call copyFunc (and the score and aggregate
+ * functions) at once. the threads are made and joined like in unionRBTree. a tree with an
+ * allocator is copied only by the calling thread, since the allocator may not be safe for threads.
+ * @param tree: the tree to copy.
+ * @param copyFunc: the function to copy the items with. may be NULL, in which case the copy holds
+ * the same items and does not free them. ignored by a tree that keeps copies of its items (inside
+ * its nodes or in its arena), which copies them like it does when they are added. the copy of a
+ * map holds the same values, and does not free them.
+ * @param maxThreads: the most threads to run at once, the calling one among them (1 or less to use
+ * only the calling thread).
+ * @return: the copy, or NULL on failure (or if the tree is intrusive, or has an allocator with a
+ * reset function).
+ */
+RBTree *cloneRBTree(RBTree *tree, CopyFunc copyFunc, int maxThreads);
+
+/**
+ * add an item to the tree. in a multiset, an item that is already in the tree is counted once
+ * more instead, and the tree keeps the item it already has: the added one is freed with the
+ * FreeFunc (unless the tree keeps copies of its items, in which case the caller keeps owning it).
+ * in a map, the item is added as a key with no value (see putRBTree).
  * @param tree: the tree to add an item to.
  * @param data: item to add to the tree.
- * @return: 0 on failure, other on success. (if the item is already in the tree - failure).
+ * @return: 0 on failure, other on success. (if the item is already in the tree - failure, other
+ * than in a multiset).
  */
 int addToRBTree(RBTree *tree, void *data); // implement it in RBTree.c
 
+/**
+ * add an item to the tree if there is no equal item in it, with a single search of the tree.
+ * @param tree: the tree to add an item to.
+ * @param data: item to add to the tree.
+ * @param inserted: set to other than 0 if the item was added, and to 0 if an equal item was
+ * already in the tree (may be NULL).
+ * @return: the item in the tree (the one that was already there, or the added one - which is the
+ * copy, in a tree that copies its items). NULL on failure. in a multiset, an item that was
+ * already there is counted once more, and the caller keeps owning the given item. if its count
+ * is already INT_MAX, it is not counted and NULL is returned.
+ */
+void *insertOrGetRBTree(RBTree *tree, void *data, int *inserted);
+
+/**
+ * add a run of sorted items to the tree. every item is searched for from the place of the item
+ * before it, so close items cost only a few comparisons each.
+ * @param tree: the tree to add the items to.
+ * @param items: the items, in an ascending order (any order works, but slower).
+ * @param n: the amount of items.
+ * @param results: may be NULL. results[i] is set to 0 if items[i] failed to be added (if it is
+ * already in the tree, or on an allocation failure), and to other on success.
+ * @return: the amount of items that were added. in a multiset, the items that were already in
+ * the tree are counted and freed like addToRBTree does, and are added to the amount.
+ */
+int addSortedToRBTree(RBTree *tree, void **items, int n, int *results);
+
+/**
+ * add an item to the tree, searching for its place from the item of a cursor instead of from the
+ * root: the search climbs only as far as the item is from the cursor. adding items that are
+ * mostly increasing with a cursor that was put on the last item (by cursorLastRBTree) takes O(1)
+ * comparisons each, and so does adding mostly decreasing items from the first item. in a threaded
+ * tree, the climb itself takes O(1) too. works like addToRBTree otherwise.
+ * @param tree: the tree to add an item to.
+ * @param data: item to add to the tree.
+ * @param cursor: the cursor to start the search from (a cursor with no item, or on another tree,
+ * starts from the root). it is moved to the added item, or to the item that was already in the
+ * tree, so adding the next item starts from there.
+ * @return: 0 on failure, other on success. (if the item is already in the tree - failure, other
+ * than in a multiset).
+ */
+int addNearRBTree(RBTree *tree, void *data, RBTreeCursor *cursor);
+
 /**
  * check whether the tree contains this item.
  * @param tree: the tree to add an item to.
@@ -76,6 +394,70 @@ int addToRBTree(RBTree *tree, void *data); // implement it in RBTree.c
  */
 int containsRBTree(RBTree *tree, void *data); // implement it in RBTree.c
 
+/**
+ * find an item of the tree, searching for it from the item of a cursor instead of from the root:
+ * the search climbs only as far as the item is from the cursor, so looking up items close to each
+ * other takes O(1) comparisons each (see addNearRBTree).
+ * @param tree: the tree to search in.
+ * @param data: an item equal to the one to find.
+ * @param cursor: the cursor to start the search from (a cursor with no item, or on another tree,
+ * starts from the root). it is moved to the found item, and left as it was if there is none.
+ * @return: the item in the tree, or NULL if it is not in the tree.
+ */
+void *findNearRBTree(RBTree *tree, void *data, RBTreeCursor *cursor);
+
+/**
+ * tell how many times an item was added to a multiset. takes O(log n).
+ * @param tree: the tree to search in.
+ * @param data: item to check.
+ * @return: the amount of times the item is in the tree (0 if it is not in it, and at most 1 if
+ * the tree is not a multiset).
+ */
+int countRBTree(RBTree *tree, void *data);
+
+/**
+ * set the value of a key in a map, with a single search of the tree. a key that is not in the
+ * tree is added with the value. otherwise, the value of the key is replaced in place (and the old
+ * one is freed with the valueFreeFunc), and the tree keeps the key it already has: the given one
+ * is freed with the FreeFunc (unless the tree keeps copies of its keys, in which case the caller
+ * keeps owning it).
+ * @param tree: the map to set the value in.
+ * @param key: the key of the value.
+ * @param value: the value (may be NULL).
+ * @return: 0 on failure (or if the tree is not a map), other on success.
+ */
+int putRBTree(RBTree *tree, void *key, void *value);
+
+/**
+ * find the value of a key in a map. takes O(log n).
+ * @param tree: the map to search in.
+ * @param key: the key to search for.
+ * @return: the value of the key, or NULL if the key is not in the tree (or if the tree is not a
+ * map).
+ */
+void *getRBTree(RBTree *tree, void *key);
+
+/**
+ * remove an item from the tree, and free it with the FreeFunc of the tree. takes O(log n). in a
+ * multiset, an item that was added more than once is only counted once less. in a map, the value
+ * of the item is freed with the valueFreeFunc.
+ * @param tree: the tree to remove an item from.
+ * @param data: an item equal to the one to remove.
+ * @return: 0 on failure, other on success. (if the item is not in the tree - failure).
+ */
+int removeFromRBTree(RBTree *tree, void *data);
+
+/**
+ * remove an item from the tree without freeing it, and hand it back to the caller. takes O(log n).
+ * a copy in the arena of the tree stays valid until the tree is freed. not supported by a tree
+ * that keeps its items inside its nodes. in a multiset, the item is taken out however many times
+ * it was added. in a map, the value of the item is freed with the valueFreeFunc.
+ * @param tree: the tree to remove an item from.
+ * @param data: an item equal to the one to remove.
+ * @return: the removed item, which the caller now owns, or NULL if it is not in the tree.
+ */
+void *takeFromRBTree(RBTree *tree, void *data);
+
 
 
 /**
@@ -88,6 +470,320 @@ int containsRBTree(RBTree *tree, void *data); // implement it in RBTree.c
  */
 int forEachRBTree(RBTree *tree, forEachFunc func, void *args); // implement it in RBTree.c
 
+/**
+ * find the smallest item of the tree. takes O(1) in a threaded tree, and O(log n) otherwise.
+ * @param tree: the tree to search in.
+ * @return: the smallest item, or NULL if the tree is empty.
+ */
+void *minRBTree(RBTree *tree);
+
+/**
+ * find the greatest item of the tree. takes O(1) in a threaded tree, and O(log n) otherwise.
+ * @param tree: the tree to search in.
+ * @return: the greatest item, or NULL if the tree is empty.
+ */
+void *maxRBTree(RBTree *tree);
+
+/**
+ * find the item with the greatest score, in a tree that was made with a maxScoreFunc. takes O(1).
+ * if some items share the greatest score, the smallest of them is returned.
+ * @param tree: the tree to search in.
+ * @return: the item (which still belongs to the tree), or NULL if the tree is empty or has no
+ * maxScoreFunc.
+ */
+void *maxScoreRBTree(RBTree *tree);
+
+/**
+ * find the smallest item that is not smaller than the given item. takes O(log n).
+ * @param tree: the tree to search in.
+ * @param data: the item to compare with (does not have to be in the tree).
+ * @return: the found item, or NULL if there is none.
+ */
+void *lowerBoundRBTree(RBTree *tree, void *data);
+
+/**
+ * find the smallest item that is greater than the given item. takes O(log n).
+ * @param tree: the tree to search in.
+ * @param data: the item to compare with (does not have to be in the tree).
+ * @return: the found item, or NULL if there is none.
+ */
+void *upperBoundRBTree(RBTree *tree, void *data);
+
+/**
+ * find the greatest item that is not greater than the given item. takes O(log n).
+ * @param tree: the tree to search in.
+ * @param data: the item to compare with (does not have to be in the tree).
+ * @return: the found item, or NULL if there is none.
+ */
+void *floorRBTree(RBTree *tree, void *data);
+
+/**
+ * find the smallest item that is not smaller than the given item (the same as lowerBoundRBTree).
+ * takes O(log n).
+ * @param tree: the tree to search in.
+ * @param data: the item to compare with (does not have to be in the tree).
+ * @return: the found item, or NULL if there is none.
+ */
+void *ceilingRBTree(RBTree *tree, void *data);
+
+/**
+ * Activate a function on each item of the tree between two items (including them), in an
+ * ascending order. if one of the activations of the function returns 0, the process stops.
+ * takes O(log n + k) for k items in the range.
+ * @param tree: the tree with all the items.
+ * @param low: the lowest item of the range (does not have to be in the tree).
+ * @param high: the highest item of the range (does not have to be in the tree).
+ * @param func: the function to activate on the items.
+ * @param args: more optional arguments to the function (may be null if the given function support it).
+ * @return: 0 on failure, other on success.
+ */
+int forEachInRangeRBTree(RBTree *tree, void *low, void *high, forEachFunc func, void *args);
+
+/**
+ * Activate a function on each item of the tree between two items (including them), in a
+ * descending order. if one of the activations of the function returns 0, the process stops.
+ * takes O(log n + k) for k items in the range.
+ * @param tree: the tree with all the items.
+ * @param low: the lowest item of the range (does not have to be in the tree).
+ * @param high: the highest item of the range (does not have to be in the tree).
+ * @param func: the function to activate on the items.
+ * @param args: more optional arguments to the function (may be null if the given function support it).
+ * @return: 0 on failure, other on success.
+ */
+int forEachInRangeReverseRBTree(RBTree *tree, void *low, void *high, forEachFunc func, void *args);
+
+/**
+ * Activate a function on each item of the tree with the amount of times it is in the tree (1 for
+ * every item, if the tree is not a multiset). the order is an ascending order. if one of the
+ * activations of the function returns 0, the process stops.
+ * @param tree: the tree with all the items.
+ * @param func: the function to activate on all items.
+ * @param args: more optional arguments to the function (may be null if the given function support it).
+ * @return: 0 on failure, other on success.
+ */
+int forEachCountRBTree(RBTree *tree, forEachCountFunc func, void *args);
+
+/**
+ * Activate a function on each key of a map with its value. the order is an ascending order of the
+ * keys. the function may change the values in place. if one of the activations of the function
+ * returns 0, the process stops.
+ * @param tree: the map with all the keys.
+ * @param func: the function to activate on all the keys.
+ * @param args: more optional arguments to the function (may be null if the given function support it).
+ * @return: 0 on failure (or if the tree is not a map), other on success.
+ */
+int forEachPairRBTree(RBTree *tree, forEachPairFunc func, void *args);
+
+/**
+ * Activate a function on each item of the tree between two items (including them) with the
+ * amount of times it is in the tree, in an ascending order. if one of the activations of the
+ * function returns 0, the process stops. takes O(log n + k) for k items in the range.
+ * @param tree: the tree with all the items.
+ * @param low: the lowest item of the range (does not have to be in the tree).
+ * @param high: the highest item of the range (does not have to be in the tree).
+ * @param func: the function to activate on the items.
+ * @param args: more optional arguments to the function (may be null if the given function support it).
+ * @return: 0 on failure, other on success.
+ */
+int forEachInRangeCountRBTree(RBTree *tree, void *low, void *high, forEachCountFunc func,
+                              void *args);
+
+/**
+ * put the cursor on the smallest item of the tree.
+ * @param tree: the tree to walk over.
+ * @param cursor: the cursor to set.
+ * @return: the item, or NULL if the tree is empty.
+ */
+void *cursorFirstRBTree(RBTree *tree, RBTreeCursor *cursor);
+
+/**
+ * put the cursor on the greatest item of the tree.
+ * @param tree: the tree to walk over.
+ * @param cursor: the cursor to set.
+ * @return: the item, or NULL if the tree is empty.
+ */
+void *cursorLastRBTree(RBTree *tree, RBTreeCursor *cursor);
+
+/**
+ * put the cursor on the smallest item that is not smaller than the given item. takes O(log n).
+ * @param tree: the tree to walk over.
+ * @param cursor: the cursor to set.
+ * @param data: the item to compare with (does not have to be in the tree).
+ * @return: the item, or NULL if there is none.
+ */
+void *cursorSeekRBTree(RBTree *tree, RBTreeCursor *cursor, void *data);
+
+/**
+ * move the cursor to the next item. takes amortized O(1).
+ * @param cursor: the cursor to move.
+ * @return: the next item, or NULL if the cursor was on the last item (or past the end).
+ */
+void *cursorNextRBTree(RBTreeCursor *cursor);
+
+/**
+ * move the cursor to the previous item. takes amortized O(1).
+ * @param cursor: the cursor to move.
+ * @return: the previous item, or NULL if the cursor was on the first item (or past the end).
+ */
+void *cursorPrevRBTree(RBTreeCursor *cursor);
+
+/**
+ * @param cursor: a cursor.
+ * @return: the item the cursor is on, or NULL if it is past the end.
+ */
+void *cursorDataRBTree(const RBTreeCursor *cursor);
+
+/**
+ * tell the rank of an item: the amount of items in the tree that are smaller than it. takes
+ * O(log n) in a tree with order statistics.
+ * @param tree: the tree to search in.
+ * @param data: the item to rank (does not have to be in the tree).
+ * @return: the rank, or -1 on failure (or if the tree has no order statistics).
+ */
+int rankRBTree(RBTree *tree, void *data);
+
+/**
+ * find the item of the given rank. takes O(log n) in a tree with order statistics.
+ * @param tree: the tree to search in.
+ * @param k: the rank of the item, from 0 (the smallest item) to the size of the tree minus 1.
+ * @return: the item, or NULL if there is no such item (or if the tree has no order statistics).
+ */
+void *selectRBTree(RBTree *tree, int k);
+
+/**
+ * count the items between two items (including them). takes O(log n) in a tree with order
+ * statistics.
+ * @param tree: the tree to count in.
+ * @param low: the lowest item of the range (does not have to be in the tree).
+ * @param high: the highest item of the range (does not have to be in the tree).
+ * @return: the amount of items in the range, or -1 on failure (or if the tree has no order
+ * statistics).
+ */
+int countRangeRBTree(RBTree *tree, void *low, void *high);
+
+/**
+ * pick an item of the tree uniformly at random. takes O(log n) in a tree with order statistics.
+ * @param tree: the tree to pick from.
+ * @param randomValue: a uniformly random number, from the random source of the caller.
+ * @return: the item, or NULL if the tree is empty (or has no order statistics).
+ */
+void *sampleRBTree(RBTree *tree, unsigned long long randomValue);
+
+/**
+ * get the aggregate of all the items of the tree, in a tree that keeps aggregates. takes O(1).
+ * @param tree: the tree to get the aggregate of.
+ * @return: the aggregate (which belongs to the tree, and changes with it), or NULL if the tree is
+ * empty (or keeps no aggregates).
+ */
+const void *aggregateRBTree(RBTree *tree);
+
+/**
+ * get the aggregate of the items between two items (including them), in a tree that keeps
+ * aggregates. takes O(log n).
+ * @param tree: the tree to aggregate in.
+ * @param low: the lowest item of the range (does not have to be in the tree).
+ * @param high: the highest item of the range (does not have to be in the tree).
+ * @param result: where to put the aggregate (aggregateSize bytes). left as is if the range is
+ * empty.
+ * @return: 0 on failure or if the range is empty, other on success.
+ */
+int rangeAggregateRBTree(RBTree *tree, void *low, void *high, void *result);
+
+/**
+ * move all the items that are not smaller than the given item to a new tree. takes O(log n) in a
+ * tree with order statistics and no sizeFunc. otherwise, the smaller part of the tree is walked to
+ * divide the sizes and the memory between the parts, so a split that leaves k of n items in the
+ * tree takes O(log n + min(k, n - k)). the nodes are moved and not copied, so the two trees share
+ * their memory until both are freed. cursors on the tree are no longer valid.
+ * @param tree: the tree to split. keeps the items smaller than key.
+ * @param key: the item to split at (does not have to be in the tree).
+ * @return: a new tree with the same settings, that holds the items not smaller than key. NULL on
+ * failure (or if the tree has an allocator with a reset function), in which case the tree is left
+ * as it was.
+ */
+RBTree *splitRBTree(RBTree *tree, void *key);
+
+/**
+ * move all the items of a tree to the end of another tree, whose items are all smaller. takes
+ * O(log n). the nodes are moved and not copied, so the memory of the trees is shared until all of
+ * their nodes are freed. cursors on both trees are no longer valid.
+ * @param left: the tree to add the items to.
+ * @param right: the tree to take the items from. it must have the same settings as left, and
+ * only items greater than those of left. it is freed on success.
+ * @return: 0 on failure (if the settings are not the same, if the items are not in order or if
+ * the trees have an allocator with a reset function), in which case both trees are left as they
+ * were. other on success.
+ */
+int joinRBTree(RBTree *left, RBTree *right);
+
+/**
+ * move the items of another tree into a tree. takes O(m log(n / m + 1)) for trees of m and n
+ * items (m <= n), and splits the work so that no more than maxThreads threads (the calling one
+ * among them) run at once. the nodes are moved and not copied, so the memory of the trees is
+ * shared until all of their nodes are freed. the CompareFunc (and the aggregate functions) are
+ * called from several threads at once. in a threaded tree, the links are made anew, which takes
+ * O(n + m). the threads are POSIX threads, made for the part of the work they do and joined when
+ * it is done (there are at most maxThreads - 1 of them, so no pool is kept), and the program is
+ * linked with -pthread (or RBTree.c is compiled with RBTREE_NO_THREADS, to do all the work in the
+ * calling thread).
+ * @param tree: the tree to add the items to.
+ * @param other: the tree to take the items from. it must have the same settings as tree. it is
+ * freed on success, and so are its items that tree already has an equal item to.
+ * @param maxThreads: the most threads to run at once, the calling one among them (1 or less to use
+ * only the calling thread).
+ * @return: 0 on failure (if the settings are not the same, if the trees are multisets or if they
+ * have an allocator with a reset function), in which case both trees are left as they were. other on success.
+ */
+int unionRBTree(RBTree *tree, RBTree *other, int maxThreads);
+
+/**
+ * keep in a tree only the items that another tree has an equal item to. takes and works like
+ * unionRBTree.
+ * @param tree: the tree to keep the items in. the items it does not keep are freed.
+ * @param other: the tree to compare with. it must have the same settings as tree. it is freed on
+ * success, with all of its items.
+ * @param maxThreads: the most threads to run at once, the calling one among them (1 or less to use
+ * only the calling thread).
+ * @return: 0 on failure (if the settings are not the same, if the trees are multisets or if they
+ * have an allocator with a reset function), in which case both trees are left as they were. other on success.
+ */
+int intersectRBTree(RBTree *tree, RBTree *other, int maxThreads);
+
+/**
+ * remove from a tree all the items that another tree has an equal item to. takes and works like
+ * unionRBTree.
+ * @param tree: the tree to remove the items from. the removed items are freed.
+ * @param other: the tree with the items to remove. it must have the same settings as tree. it is
+ * freed on success, with all of its items.
+ * @param maxThreads: the most threads to run at once, the calling one among them (1 or less to use
+ * only the calling thread).
+ * @return: 0 on failure (if the settings are not the same, if the trees are multisets or if they
+ * have an allocator with a reset function), in which case both trees are left as they were. other on success.
+ */
+int differenceRBTree(RBTree *tree, RBTree *other, int maxThreads);
+
+/**
+ * move the items of many trees into the first of them, by uniting them in pairs, so every item
+ * takes part in O(log k) unions of k trees.
+ * @param trees: the trees to unite. they must all have the same settings. the first one gets the
+ * items, and all the others are freed on success (and set to NULL in trees).
+ * @param n: the amount of trees.
+ * @param maxThreads: the most threads every union uses (1 or less to use only the calling thread).
+ * @return: 0 on failure (if the settings are not the same, if the trees are multisets or if a
+ * tree is given twice), in which case all the trees are left as they were. other on success. if
+ * a union fails after these checks, the unions that were done are kept, and 0 is returned with
+ * the trees that are left in trees.
+ */
+int unionManyRBTree(RBTree **trees, int n, int maxThreads);
+
+/**
+ * tell how much memory the tree uses. takes O(1).
+ * @param tree: the tree to check.
+ * @param memory: where to put the amounts.
+ * @return: 0 on failure, other on success.
+ */
+int getRBTreeMemory(const RBTree *tree, RBTreeMemory *memory);
+
 /**
  * free all memory of the data structure.
  * @param tree: the tree to free.
@@ -0,0 +1,410 @@
+/**
+* @file RBTreeTest.c
+* @version 1.0
+*
+* @brief Checks the operations that rebuild the structure of a Red Black Tree.
+*
+* @section DESCRIPTION
+* Random trees of ints are split and joined, and united, intersected and subtracted with one and
+* with several threads. Every resulting tree is checked against the set of items it should hold:
+* the red black rules, the parent links, the order of the items, the size, the order statistics
+* and the links of a threaded tree. Run with "make test".
+*/
+
+// ------------------------------ includes ------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "RBTree.h"
+
+// -------------------------- const definitions -------------------------
+
+// Stands for success or failure of a function
+#define FAILURE (0)
+#define SUCCESS (1)
+
+// The items of the trees are ints from 0 up to this range
+#define ITEM_RANGE (20000)
+
+// The amount of random trees every check is done on
+#define ROUNDS (20)
+
+// The items of the trees of the set operations are ints from 0 up to this range. the trees are
+// big enough for the operations to be split between threads
+#define SET_RANGE (600000)
+
+// The most threads the set operations are checked with
+#define MAX_THREADS (3)
+
+// The most threads that are counted by threadCompare
+#define MAX_COUNTED_THREADS (64)
+
+// The settings every check is done with: plain, with order statistics, threaded, and both
+#define SETTINGS (4)
+
+// ------------------------------ globals -------------------------------
+
+// The threads that called threadCompare, and the lock that guards them
+pthread_mutex_t threadsLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_t seenThreads[MAX_COUNTED_THREADS];
+int seenThreadsCount = 0;
+
+// ------------------------------ functions -----------------------------
+
+/**
+ * @brief CompareFunc for ints
+ * @param a pointer to an int
+ * @param b pointer to an int
+ * @return a negative number if a < b, a positive one if a > b and 0 if they are equal
+ */
+int intCompare(const void *a, const void *b)
+{
+    int first = *(const int *) a;
+    int second = *(const int *) b;
+    return (first > second) - (first < second);
+}
+
+/**
+ * @brief CompareFunc for ints, that also keeps the threads that call it in seenThreads
+ * @param a pointer to an int
+ * @param b pointer to an int
+ * @return a negative number if a < b, a positive one if a > b and 0 if they are equal
+ */
+int threadCompare(const void *a, const void *b)
+{
+    pthread_t self = pthread_self();
+    pthread_mutex_lock(&threadsLock);
+    int isSeen = 0;
+    for (int i = 0; i < seenThreadsCount && !isSeen; i++)
+    {
+        isSeen = pthread_equal(seenThreads[i], self);
+    }
+    if (!isSeen && seenThreadsCount < MAX_COUNTED_THREADS)
+    {
+        seenThreads[seenThreadsCount++] = self;
+    }
+    pthread_mutex_unlock(&threadsLock);
+    return intCompare(a, b);
+}
+
+/**
+ * @brief allocates an int
+ * @param value the value of the int
+ * @return the new int (the program stops if the allocation failed)
+ */
+int *newInt(int value)
+{
+    int *item = (int *) malloc(sizeof(int));
+    if (item == NULL)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    *item = value;
+    return item;
+}
+
+/**
+ * @brief makes a tree with the settings of the given number
+ * @param setting 0 to SETTINGS - 1: bit 0 adds order statistics, bit 1 makes the tree threaded
+ * @param compFunc the function to compare the items with
+ * @return the new tree
+ */
+RBTree *newTestTree(int setting, CompareFunc compFunc)
+{
+    RBTreeOptions options = {0};
+    options.hasOrderStatistics = setting & 1;
+    options.isThreaded = (setting & 2) != 0;
+    RBTree *tree = newRBTreeWithOptions(compFunc, free, &options);
+    if (tree == NULL)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return tree;
+}
+
+/**
+ * @brief adds random items to the tree, and marks them in the given set
+ * @param tree the tree to add to
+ * @param amount the amount of items to try to add
+ * @param expected ITEM_RANGE flags, one for every item the tree holds
+ */
+void fillTree(RBTree *tree, int amount, char *expected)
+{
+    for (int i = 0; i < amount; i++)
+    {
+        int value = rand() % ITEM_RANGE;
+        int *item = newInt(value);
+        if (!addToRBTree(tree, item))
+        {
+            free(item);
+        }
+        expected[value] = 1;
+    }
+}
+
+/**
+ * @brief adds every item of the range to the tree at the given chance, from the smallest one up,
+ * and marks them in the given set. items that are added in order make a tree with a big black
+ * height, whose set operations are split between threads.
+ * @param tree the tree to add to
+ * @param percent the chance of every item to be added
+ * @param expected SET_RANGE flags, one for every item the tree holds
+ */
+void fillTreeInOrder(RBTree *tree, int percent, char *expected)
+{
+    for (int value = 0; value < SET_RANGE; value++)
+    {
+        if (rand() % 100 < percent)
+        {
+            addToRBTree(tree, newInt(value));
+            expected[value] = 1;
+        }
+    }
+}
+
+/**
+ * @brief checks the red black rules, the parent links and the order statistics of a subtree
+ * @param tree the tree of the subtree
+ * @param node the root of the subtree
+ * @param parent the node that should be the parent of the root
+ * @param blackHeight the black height of the subtree is put here
+ * @return the amount of nodes in the subtree, -1 if a rule is broken
+ */
+int checkSubtree(const RBTree *tree, const Node *node, const Node *parent, int *blackHeight)
+{
+    *blackHeight = 0;
+    if (node == NULL)
+    {
+        return 0;
+    }
+    int leftHeight, rightHeight;
+    int leftSize = checkSubtree(tree, node->left, node, &leftHeight);
+    int rightSize = checkSubtree(tree, node->right, node, &rightHeight);
+    if (leftSize < 0 || rightSize < 0 || node->parent != parent || leftHeight != rightHeight)
+    {
+        return -1;
+    }
+    if (node->color == RED && ((node->left != NULL && node->left->color == RED)
+                               || (node->right != NULL && node->right->color == RED)))
+    {
+        return -1;
+    }
+    if (tree->hasOrderStatistics && node->subtreeSize != leftSize + rightSize + 1)
+    {
+        return -1;
+    }
+    *blackHeight = leftHeight + (node->color == BLACK);
+    return leftSize + rightSize + 1;
+}
+
+/**
+ * @brief checks that a tree is a valid Red Black Tree that holds exactly the given items
+ * @param tree the tree to check
+ * @param expected flags, one for every item the tree should hold
+ * @param range the amount of flags
+ * @return 1 if the tree is right, 0 otherwise
+ */
+int checkTree(RBTree *tree, const char *expected, int range)
+{
+    int blackHeight;
+    if ((tree->root != NULL && tree->root->color != BLACK)
+        || checkSubtree(tree, tree->root, NULL, &blackHeight) != tree->size)
+    {
+        return FAILURE;
+    }
+    // the cursor follows the links of a threaded tree, and the structure of any other tree
+    RBTreeCursor cursor;
+    int count = 0;
+    int previous = -1;
+    for (const int *item = (const int *) cursorFirstRBTree(tree, &cursor); item != NULL;
+         item = (const int *) cursorNextRBTree(&cursor))
+    {
+        if (*item <= previous || !expected[*item])
+        {
+            return FAILURE;
+        }
+        if (tree->hasOrderStatistics && (rankRBTree(tree, (void *) item) != count
+                                         || selectRBTree(tree, count) != item))
+        {
+            return FAILURE;
+        }
+        previous = *item;
+        count++;
+    }
+    int expectedCount = 0;
+    for (int i = 0; i < range; i++)
+    {
+        expectedCount += expected[i];
+    }
+    if (count != expectedCount || count != tree->size)
+    {
+        return FAILURE;
+    }
+    for (const int *item = (const int *) cursorLastRBTree(tree, &cursor); item != NULL;
+         item = (const int *) cursorPrevRBTree(&cursor))
+    {
+        count--;
+    }
+    return count == 0;
+}
+
+/**
+ * @brief splits random trees at random items, checks both parts, and joins them back
+ * @param setting the settings of the trees (see newTestTree)
+ * @return 1 if all the trees were right, 0 otherwise
+ */
+int testSplitJoin(int setting)
+{
+    char *expected = (char *) calloc(ITEM_RANGE, 1);
+    char *expectedRight = (char *) calloc(ITEM_RANGE, 1);
+    if (expected == NULL || expectedRight == NULL)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    int isRight = SUCCESS;
+    for (int round = 0; round < ROUNDS && isRight; round++)
+    {
+        memset(expected, 0, ITEM_RANGE);
+        RBTree *tree = newTestTree(setting, intCompare);
+        // the first round splits an empty tree, and the last ones split at the ends
+        fillTree(tree, round == 0 ? 0 : rand() % (2 * ITEM_RANGE), expected);
+        int key = round == ROUNDS - 1 ? ITEM_RANGE : round == ROUNDS - 2 ? 0 : rand() % ITEM_RANGE;
+        RBTree *right = splitRBTree(tree, &key);
+        memset(expectedRight, 0, ITEM_RANGE);
+        for (int i = key; i < ITEM_RANGE; i++)
+        {
+            expectedRight[i] = expected[i];
+            expected[i] = 0;
+        }
+        isRight = right != NULL && checkTree(tree, expected, ITEM_RANGE)
+                  && checkTree(right, expectedRight, ITEM_RANGE);
+        // the parts can not be joined in the wrong order, unless one of them is empty
+        if (isRight && tree->size != 0 && right->size != 0)
+        {
+            isRight = !joinRBTree(right, tree) && checkTree(tree, expected, ITEM_RANGE)
+                      && checkTree(right, expectedRight, ITEM_RANGE);
+        }
+        if (isRight)
+        {
+            isRight = joinRBTree(tree, right);
+            right = NULL;
+            for (int i = key; i < ITEM_RANGE; i++)
+            {
+                expected[i] = expectedRight[i];
+            }
+            isRight = isRight && checkTree(tree, expected, ITEM_RANGE);
+        }
+        // the joined tree is still changed like any other tree
+        for (int i = 0; i < 1000 && isRight; i++)
+        {
+            int value = rand() % ITEM_RANGE;
+            if (rand() % 2)
+            {
+                int *item = newInt(value);
+                if (!addToRBTree(tree, item))
+                {
+                    free(item);
+                }
+                expected[value] = 1;
+            }
+            else
+            {
+                removeFromRBTree(tree, &value);
+                expected[value] = 0;
+            }
+        }
+        isRight = isRight && checkTree(tree, expected, ITEM_RANGE);
+        freeRBTree(right);
+        freeRBTree(tree);
+    }
+    free(expected);
+    free(expectedRight);
+    return isRight;
+}
+
+/**
+ * @brief does a set operation on two trees, one of them empty in the first round, and checks the
+ * result and the amount of threads that did it
+ * @param setting the settings of the trees (see newTestTree)
+ * @param operation 0 for union, 1 for intersection and 2 for difference
+ * @param maxThreads the most threads the operation may use
+ * @return 1 if the results were right, 0 otherwise
+ */
+int testSetOperation(int setting, int operation, int maxThreads)
+{
+    char *expected = (char *) calloc(SET_RANGE, 1);
+    char *expectedOther = (char *) calloc(SET_RANGE, 1);
+    if (expected == NULL || expectedOther == NULL)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    int isRight = SUCCESS;
+    for (int round = 0; round < 2 && isRight; round++)
+    {
+        memset(expected, 0, SET_RANGE);
+        memset(expectedOther, 0, SET_RANGE);
+        RBTree *tree = newTestTree(setting, threadCompare);
+        RBTree *other = newTestTree(setting, threadCompare);
+        fillTreeInOrder(tree, 50, expected);
+        fillTreeInOrder(other, round == 0 ? 0 : 50, expectedOther);
+        // the other tree shares its memory with a part of itself, like trees that were split
+        int middle = SET_RANGE / 2;
+        RBTree *otherRight = splitRBTree(other, &middle);
+        isRight = otherRight != NULL && joinRBTree(other, otherRight);
+        seenThreadsCount = 0;
+        isRight = isRight && (operation == 0 ? unionRBTree(tree, other, maxThreads)
+                              : operation == 1 ? intersectRBTree(tree, other, maxThreads)
+                              : differenceRBTree(tree, other, maxThreads));
+        int usedThreads = seenThreadsCount;
+        for (int i = 0; i < SET_RANGE; i++)
+        {
+            expected[i] = operation == 0 ? expected[i] || expectedOther[i]
+                          : operation == 1 ? expected[i] && expectedOther[i]
+                          : expected[i] && !expectedOther[i];
+        }
+        // the big trees are split between all the threads, and never between more
+        isRight = isRight && usedThreads <= maxThreads
+                  && (round == 0 || usedThreads == maxThreads)
+                  && checkTree(tree, expected, SET_RANGE);
+        freeRBTree(tree);
+    }
+    free(expected);
+    free(expectedOther);
+    return isRight;
+}
+
+/**
+ * runs the checks.
+ * @return 0 if all of them passed, 1 otherwise
+ */
+int main(void)
+{
+    srand(12345);
+    int failures = 0;
+    for (int setting = 0; setting < SETTINGS; setting++)
+    {
+        int isRight = testSplitJoin(setting);
+        printf("split and join, setting %d: %s\n", setting, isRight ? "passed" : "FAILED");
+        failures += !isRight;
+    }
+    const char *operationNames[] = {"union", "intersection", "difference"};
+    for (int setting = 0; setting < SETTINGS; setting++)
+    {
+        for (int operation = 0; operation < 3; operation++)
+        {
+            for (int maxThreads = 1; maxThreads <= MAX_THREADS; maxThreads += MAX_THREADS - 1)
+            {
+                int isRight = testSetOperation(setting, operation, maxThreads);
+                printf("%s with %d threads, setting %d: %s\n", operationNames[operation],
+                       maxThreads, setting, isRight ? "passed" : "FAILED");
+                failures += !isRight;
+            }
+        }
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
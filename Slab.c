@@ -0,0 +1,291 @@
+/**
+* @file Slab.c
+* @version 1.0
+*
+* @brief A chunked pool of fixed size items, used by the RBTree to allocate its nodes.
+*
+* @section DESCRIPTION
+* The chunks grow geometrically until they reach the size of a huge page, so small trees stay
+* small and big trees need only a few chunks. When asked to, the chunks are mapped with huge
+* pages (falling back to transparent huge pages, and then to malloc).
+*/
+
+// ------------------------------ includes ------------------------------
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "Slab.h"
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// -------------------------- const definitions -------------------------
+
+// The error massage that is to be printed if an error occurred when using malloc
+#define ERR_MALLOC "Memory allocation failed\n"
+
+// The alignment of every item of the slab
+#define SLAB_ALIGNMENT (sizeof(double) > sizeof(void *) ? sizeof(double) : sizeof(void *))
+
+// The size of the chunk header, rounded so the items after it stay aligned
+#define CHUNK_HEADER_SIZE (slabRoundUp(sizeof(SlabChunk), SLAB_ALIGNMENT))
+
+// The amount of items in the first chunk of a slab
+#define FIRST_CHUNK_ITEMS (32)
+
+// The size of a huge page, which is also the biggest size of a chunk
+#define HUGE_PAGE_SIZE ((size_t) 2 * 1024 * 1024)
+
+// ------------------------------ functions -----------------------------
+
+/**
+ * @brief rounds the given size up to a multiple of the given alignment
+ * @param size the size to round
+ * @param alignment the alignment to round to
+ * @return the rounded size
+ */
+size_t slabRoundUp(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * initializes an empty slab. no memory is allocated until the first item is asked for.
+ * @param slab: the slab to initialize.
+ * @param itemSize: the size of every item of the slab.
+ * @param useHugePages: other than 0 to back the chunks with huge pages when the system has them.
+ * @param allocator: where to get the chunks from (may be NULL for malloc). it must live as long as
+ * the slab. huge pages are used only without an allocator.
+ */
+void initSlab(Slab *slab, size_t itemSize, int useHugePages, const Allocator *allocator)
+{
+    if (itemSize < sizeof(void *))
+    {
+        itemSize = sizeof(void *);
+    }
+    slab->itemSize = slabRoundUp(itemSize, SLAB_ALIGNMENT);
+    slab->nextChunkItems = FIRST_CHUNK_ITEMS;
+    slab->chunks = NULL;
+    slab->bump = NULL;
+    slab->end = NULL;
+    slab->freeList = NULL;
+    slab->useHugePages = useHugePages && allocator == NULL;
+    slab->allocator = allocator;
+    slab->chunkBytes = 0;
+    slab->liveItems = 0;
+}
+
+/**
+ * @brief maps a chunk of the size of a huge page
+ * @return the mapped chunk, or NULL if the system could not map it
+ */
+SlabChunk *mapHugeChunk(void)
+{
+#ifdef __linux__
+    void *mapped = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    mapped = mmap(NULL, HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (mapped == MAP_FAILED)
+    {
+        // no reserved huge pages: ask for transparent ones instead. they back only memory that is
+        // aligned to their size, so twice the size is mapped, and what is around the aligned huge
+        // page is unmapped
+        char *twice = (char *) mmap(NULL, 2 * HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (twice == (char *) MAP_FAILED)
+        {
+            return NULL;
+        }
+        char *aligned = (char *) slabRoundUp((size_t) (uintptr_t) twice, HUGE_PAGE_SIZE);
+        if (aligned != twice)
+        {
+            munmap(twice, (size_t) (aligned - twice));
+        }
+        munmap(aligned + HUGE_PAGE_SIZE, (size_t) (twice + HUGE_PAGE_SIZE - aligned));
+        mapped = aligned;
+#ifdef MADV_HUGEPAGE
+        madvise(mapped, HUGE_PAGE_SIZE, MADV_HUGEPAGE);
+#endif
+    }
+    SlabChunk *chunk = (SlabChunk *) mapped;
+    chunk->bytes = HUGE_PAGE_SIZE;
+    chunk->isMapped = 1;
+    return chunk;
+#else
+    return NULL;
+#endif
+}
+
+/**
+ * @brief allocates a new chunk for the slab and makes it the one to bump items from
+ * @param slab the slab to add a chunk to
+ * @param items the amount of items the chunk has room for (at least). the chunks grow
+ * geometrically only when this is the size of the next chunk.
+ * @return 1 on success, 0 if the allocation failed
+ */
+int addChunk(Slab *slab, size_t items)
+{
+    SlabChunk *chunk = NULL;
+    size_t bytes = CHUNK_HEADER_SIZE + items * slab->itemSize;
+    if (slab->useHugePages && bytes <= HUGE_PAGE_SIZE)
+    {
+        chunk = mapHugeChunk();
+    }
+    if (chunk == NULL)
+    {
+        chunk = (SlabChunk *) (slab->allocator != NULL
+                               ? slab->allocator->alloc(bytes, slab->allocator->context)
+                               : malloc(bytes));
+        if (chunk == NULL)
+        {
+            fprintf(stderr, "%s", ERR_MALLOC);
+            return 0;
+        }
+        chunk->bytes = bytes;
+        chunk->isMapped = 0;
+        if (bytes < HUGE_PAGE_SIZE && items == slab->nextChunkItems)
+        {
+            slab->nextChunkItems *= 2;
+        }
+    }
+    chunk->next = slab->chunks;
+    slab->chunks = chunk;
+    slab->chunkBytes += chunk->bytes;
+    slab->bump = (char *) chunk + CHUNK_HEADER_SIZE;
+    slab->end = (char *) chunk + chunk->bytes;
+    return 1;
+}
+
+/**
+ * allocates an item from the slab.
+ * @param slab: the slab to allocate from.
+ * @return: a pointer to the item, or NULL if the allocation failed.
+ */
+void *slabAlloc(Slab *slab)
+{
+    if (slab->freeList != NULL)
+    {
+        void *item = slab->freeList;
+        slab->freeList = *(void **) item;
+        slab->liveItems++;
+        return item;
+    }
+    if (slab->bump == NULL || (size_t) (slab->end - slab->bump) < slab->itemSize)
+    {
+        if (!addChunk(slab, slab->nextChunkItems))
+        {
+            return NULL;
+        }
+    }
+    void *item = slab->bump;
+    slab->bump += slab->itemSize;
+    slab->liveItems++;
+    return item;
+}
+
+/**
+ * makes sure the next items are allocated one right after the other, by adding a chunk with room
+ * for all of them if the current chunk is too small. the rest of the current chunk is left unused.
+ * @param slab: the slab to allocate from.
+ * @param items: the amount of items that are about to be allocated.
+ * @return: 1 on success, 0 if the allocation failed.
+ */
+int slabReserve(Slab *slab, size_t items)
+{
+    if (items == 0
+        || (slab->bump != NULL && (size_t) (slab->end - slab->bump) / slab->itemSize >= items))
+    {
+        return 1;
+    }
+    return addChunk(slab, items > slab->nextChunkItems ? items : slab->nextChunkItems);
+}
+
+/**
+ * returns an item to the slab, so it can be handed out again.
+ * @param slab: the slab the item was allocated from.
+ * @param item: the item to return.
+ */
+void slabFree(Slab *slab, void *item)
+{
+    if (item != NULL)
+    {
+        *(void **) item = slab->freeList;
+        slab->freeList = item;
+        slab->liveItems--;
+    }
+}
+
+/**
+ * moves all the chunks of a slab (and its free items) to another slab, so they are freed with it.
+ * the items of the moved chunks that are handed out stay valid. takes O(chunks + free items).
+ * @param slab: the slab to move the chunks to. it must have the same item size and allocator.
+ * @param from: the slab to take the chunks from. it is left empty.
+ */
+void slabAdopt(Slab *slab, Slab *from)
+{
+    // the moved chunks go after the current chunk, so it keeps handing out items
+    SlabChunk **tail = &slab->chunks;
+    while (*tail != NULL)
+    {
+        tail = &(*tail)->next;
+    }
+    *tail = from->chunks;
+    slab->chunkBytes += from->chunkBytes;
+    if (from->freeList != NULL)
+    {
+        void *lastFree = from->freeList;
+        while (*(void **) lastFree != NULL)
+        {
+            lastFree = *(void **) lastFree;
+        }
+        *(void **) lastFree = slab->freeList;
+        slab->freeList = from->freeList;
+    }
+    from->chunks = NULL;
+    from->bump = NULL;
+    from->end = NULL;
+    from->freeList = NULL;
+    from->chunkBytes = 0;
+    from->liveItems = 0;
+}
+
+/**
+ * frees all the chunks of the slab, and with them all of its items.
+ * @param slab: the slab to free.
+ */
+void freeSlab(Slab *slab)
+{
+    SlabChunk *chunk = slab->chunks;
+    while (chunk != NULL)
+    {
+        SlabChunk *next = chunk->next;
+#ifdef __linux__
+        if (chunk->isMapped)
+        {
+            munmap(chunk, chunk->bytes);
+            chunk = next;
+            continue;
+        }
+#endif
+        if (slab->allocator != NULL)
+        {
+            slab->allocator->free(chunk, chunk->bytes, slab->allocator->context);
+        }
+        else
+        {
+            free(chunk);
+        }
+        chunk = next;
+    }
+    slab->chunks = NULL;
+    slab->bump = NULL;
+    slab->end = NULL;
+    slab->freeList = NULL;
+    slab->chunkBytes = 0;
+    slab->liveItems = 0;
+}
@@ -0,0 +1,107 @@
+/**
+* @file Slab.h
+* @version 1.0
+*
+* @brief A chunked pool of fixed size items, used by the RBTree to allocate its nodes.
+*
+* @section DESCRIPTION
+* Items are handed out by bumping a pointer inside the current chunk, or by reusing an item from
+* the free list. The whole pool is released at once by freeing its chunks, so there is no need
+* to free every item on its own.
+*/
+
+#ifndef RBTREE_SLAB_H
+#define RBTREE_SLAB_H
+
+#include <stddef.h>
+
+/**
+ * functions to get memory from, instead of malloc and free.
+ * alloc: allocates the given amount of bytes, returns NULL on failure.
+ * free: frees memory that alloc returned, with the size it was allocated with.
+ * reset: may be NULL. releases all the memory that was allocated from this allocator at once.
+ * context: an opaque pointer that is passed to all of the functions.
+ */
+typedef struct Allocator
+{
+	void *(*alloc)(size_t size, void *context);
+	void (*free)(void *pointer, size_t size, void *context);
+	void (*reset)(void *context);
+	void *context;
+} Allocator;
+
+/**
+ * the header of a chunk of the slab (or of an arena). the items of the chunk come right after it.
+ */
+typedef struct SlabChunk
+{
+	struct SlabChunk *next;
+	size_t bytes;
+	int isMapped;
+} SlabChunk;
+
+/**
+ * a pool of items of the same size.
+ * chunkBytes counts the memory of all the chunks, and liveItems the items that are handed out.
+ */
+typedef struct Slab
+{
+	size_t itemSize;
+	size_t nextChunkItems;
+	SlabChunk *chunks;
+	char *bump, *end;
+	void *freeList;
+	int useHugePages;
+	const Allocator *allocator;
+	size_t chunkBytes;
+	size_t liveItems;
+} Slab;
+
+/**
+ * initializes an empty slab. no memory is allocated until the first item is asked for.
+ * @param slab: the slab to initialize.
+ * @param itemSize: the size of every item of the slab.
+ * @param useHugePages: other than 0 to back the chunks with huge pages when the system has them.
+ * @param allocator: where to get the chunks from (may be NULL for malloc). it must live as long as
+ * the slab. huge pages are used only without an allocator.
+ */
+void initSlab(Slab *slab, size_t itemSize, int useHugePages, const Allocator *allocator);
+
+/**
+ * allocates an item from the slab.
+ * @param slab: the slab to allocate from.
+ * @return: a pointer to the item, or NULL if the allocation failed.
+ */
+void *slabAlloc(Slab *slab);
+
+/**
+ * makes sure the next items are allocated one right after the other, by adding a chunk with room
+ * for all of them if the current chunk is too small. the rest of the current chunk is left unused.
+ * @param slab: the slab to allocate from.
+ * @param items: the amount of items that are about to be allocated.
+ * @return: 1 on success, 0 if the allocation failed.
+ */
+int slabReserve(Slab *slab, size_t items);
+
+/**
+ * returns an item to the slab, so it can be handed out again.
+ * @param slab: the slab the item was allocated from.
+ * @param item: the item to return.
+ */
+void slabFree(Slab *slab, void *item);
+
+/**
+ * moves all the chunks of a slab (and its free items) to another slab, so they are freed with it.
+ * the items of the moved chunks that are handed out stay valid. takes O(chunks + free items).
+ * @param slab: the slab to move the chunks to. it must have the same item size and allocator.
+ * @param from: the slab to take the chunks from. it is left empty.
+ */
+void slabAdopt(Slab *slab, Slab *from);
+
+/**
+ * frees all the chunks of the slab, and with them all of its items.
+ * @param slab: the slab to free.
+ */
+void freeSlab(Slab *slab);
+
+#endif //RBTREE_SLAB_H
@@ -72,6 +72,69 @@ void freeString(void *s)
     }
 }
 
+/**
+ * SizeFunc for strings
+ * @param s - char*
+ * @return the size of the string with its "\0"
+ */
+size_t stringSize(const void *s)
+{
+    return strlen((const char *) s) + 1;
+}
+
+/**
+ * InlineCopyFunc for strings. copies the string into the buffer if it fits there (with its
+ * "\0"), and to a new allocation otherwise.
+ * @param s - char* to copy
+ * @param buffer - the room inside the node
+ * @param bufferSize - the size of the room
+ * @return the copy, NULL on failure
+ */
+void *stringInlineCopy(const void *s, void *buffer, size_t bufferSize)
+{
+    size_t size = strlen((const char *) s) + 1;
+    char *copy = (char *) buffer;
+    if (size > bufferSize)
+    {
+        copy = (char *) malloc(size);
+        if (copy == NULL)
+        {
+            fprintf(stderr, "%s", ERR_MALLOC);
+            return NULL;
+        }
+    }
+    memcpy(copy, s, size);
+    return copy;
+}
+
+/**
+ * CopyFunc for strings. copies the string (with its "\0") to a new allocation.
+ * @param s - char* to copy
+ * @return the copy, NULL on failure
+ */
+void *stringCopy(const void *s)
+{
+    return stringInlineCopy(s, NULL, 0);
+}
+
+/**
+ * ArenaCopyFunc for strings. copies the string (with its "\0") into the arena.
+ * @param s - char* to copy
+ * @param arena - the arena of the tree
+ * @return the copy, NULL on failure
+ */
+void *stringArenaCopy(const void *s, Arena *arena)
+{
+    size_t size = strlen((const char *) s) + 1;
+    char *copy = (char *) arenaAlloc(arena, size, sizeof(char));
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+    memcpy(copy, s, size);
+    return copy;
+}
+
 /**
  * CompFunc for Vectors, compares element by element, the vector that has the first larger
  * element is considered larger. If vectors are of different lengths and identify for the length
@@ -118,6 +181,60 @@ int vectorCompare1By1(const void *a, const void *b)
     return EQUAL;
 }
 
+/**
+ * @brief calculate the norm (without the root) of the vector given
+ * @param pVector the vector to calculate it's norm
+ * @return the squared norm of the given vector
+ */
+double calculateNorm(const Vector *pVector)
+{
+    double norm = 0;
+    for (int i = 0; i < pVector->len; i++)
+    {
+        norm += ((pVector->vector)[i]) * ((pVector->vector)[i]);
+    }
+    return norm;
+}
+
+/**
+ * @brief checks whether the coordinates of the given vector are kept right after it, in the same
+ * allocation
+ * @param pVector the vector to check
+ * @return 1 if they are, 0 otherwise
+ */
+int hasEmbeddedCoordinates(const Vector *pVector)
+{
+    return pVector->vector == (double *) (pVector + 1);
+}
+
+/**
+ * Allocates a vector with a single allocation, that holds the Vector and its coordinates right
+ * after it. It is freed with freeVector, like any other vector.
+ * @param len - the amount of coordinates
+ * @param coordinates - the coordinates to copy into the vector (may be NULL to leave them unset)
+ * @return pointer to the new vector, NULL on failure
+ */
+Vector *newVector(int len, const double *coordinates)
+{
+    if (len < 0)
+    {
+        return NULL;
+    }
+    Vector *theVector = (Vector *) malloc(sizeof(Vector) + (size_t) len * sizeof(double));
+    if (theVector == NULL)
+    {
+        fprintf(stderr, "%s", ERR_MALLOC);
+        return NULL;
+    }
+    theVector->len = len;
+    theVector->vector = (double *) (theVector + 1);
+    if (coordinates != NULL && len != 0)
+    {
+        memcpy(theVector->vector, coordinates, (size_t) len * sizeof(double));
+    }
+    return theVector;
+}
+
 /**
  * FreeFunc for vectors
  */
@@ -126,7 +243,7 @@ void freeVector(void *pVector)
     Vector *theVector = (Vector *) pVector;
     if (theVector != NULL)
     {
-        if (theVector->vector != NULL)
+        if (theVector->vector != NULL && !hasEmbeddedCoordinates(theVector))
         {
             free(theVector->vector);
             theVector->vector = NULL;
@@ -136,18 +253,108 @@ void freeVector(void *pVector)
 }
 
 /**
- * @brief calculate the norm (without the root) of the vector given
- * @param pVector the vector to calculate it's norm
- * @return the squared norm of the given vector
+ * SizeFunc for vectors
+ * @param pVector - pointer to Vector
+ * @return the size of the Vector with its coordinates
  */
-double calculateNorm(const Vector *pVector)
+size_t vectorSize(const void *pVector)
 {
-    double norm = 0;
-    for (int i = 0; i < pVector->len; i++)
+    return sizeof(Vector) + (size_t) ((const Vector *) pVector)->len * sizeof(double);
+}
+
+/**
+ * InlineCopyFunc for vectors. builds the copy (the Vector with its coordinates right after it)
+ * inside the buffer if it fits there, and allocates it like any other Vector otherwise.
+ * @param pVector - the vector to copy
+ * @param buffer - the room inside the node
+ * @param bufferSize - the size of the room
+ * @return the copy, NULL on failure
+ */
+void *vectorInlineCopy(const void *pVector, void *buffer, size_t bufferSize)
+{
+    const Vector *toCopy = (const Vector *) pVector;
+    size_t coordinatesSize = (size_t) toCopy->len * sizeof(double);
+    if (sizeof(Vector) + coordinatesSize > bufferSize)
     {
-        norm += ((pVector->vector)[i]) * ((pVector->vector)[i]);
+        return newVector(toCopy->len, toCopy->vector);
     }
-    return norm;
+    Vector *copy = (Vector *) buffer;
+    copy->len = toCopy->len;
+    copy->vector = (double *) (copy + 1);
+    if (coordinatesSize != 0)
+    {
+        memcpy(copy->vector, toCopy->vector, coordinatesSize);
+    }
+    return copy;
+}
+
+/**
+ * CopyFunc for vectors. allocates the copy like any other Vector.
+ * @param pVector - the vector to copy
+ * @return the copy, NULL on failure
+ */
+void *vectorCopy(const void *pVector)
+{
+    const Vector *toCopy = (const Vector *) pVector;
+    return newVector(toCopy->len, toCopy->vector);
+}
+
+/**
+ * ArenaCopyFunc for vectors. builds the copy (the Vector with its coordinates right after it) in
+ * the arena.
+ * @param pVector - the vector to copy
+ * @param arena - the arena of the tree
+ * @return the copy, NULL on failure
+ */
+void *vectorArenaCopy(const void *pVector, Arena *arena)
+{
+    const Vector *toCopy = (const Vector *) pVector;
+    size_t coordinatesSize = (size_t) toCopy->len * sizeof(double);
+    Vector *copy = (Vector *) arenaAlloc(arena, sizeof(Vector) + coordinatesSize, sizeof(double));
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+    copy->len = toCopy->len;
+    copy->vector = (double *) (copy + 1);
+    if (coordinatesSize != 0)
+    {
+        memcpy(copy->vector, toCopy->vector, coordinatesSize);
+    }
+    return copy;
+}
+
+/**
+ * ScoreFunc for vectors, to be used as the maxScoreFunc of a tree of vectors (see
+ * maxNormVectorInTree).
+ * @param pVector - pointer to Vector
+ * @return the squared norm of the vector
+ */
+double vectorSquaredNorm(const void *pVector)
+{
+    return calculateNorm((const Vector *) pVector);
+}
+
+/**
+ * AggregateItemFunc for vectors: the aggregate is a double, the squared norm of the vector. Used
+ * with sumAggregate, it gives the total squared norm of the vectors in a range.
+ * @param aggregate - pointer to double
+ * @param pVector - pointer to Vector
+ */
+void vectorNormAggregate(void *aggregate, const void *pVector)
+{
+    *(double *) aggregate = calculateNorm((const Vector *) pVector);
+}
+
+/**
+ * AggregateCombineFunc for aggregates that are a double: sums them.
+ * @param result - pointer to double, where to put the sum
+ * @param left - pointer to double
+ * @param right - pointer to double
+ */
+void sumAggregate(void *result, const void *left, const void *right)
+{
+    *(double *) result = *(const double *) left + *(const double *) right;
 }
 
 /**
@@ -193,8 +400,19 @@ int copyIfNormIsLarger(const void *pVector, void *pMaxVector)
     }
     if (calculateNorm(curVector) > calculateNorm(maxVector))
     {
-        maxVector->vector = (double *) realloc(maxVector->vector,
-                                               (curVector->len) * sizeof(double));
+        if (hasEmbeddedCoordinates(maxVector))
+        {
+            // the coordinates share the allocation of the Vector, so they can't be reallocated
+            if (curVector->len > maxVector->len)
+            {
+                maxVector->vector = (double *) malloc((curVector->len) * sizeof(double));
+            }
+        }
+        else
+        {
+            maxVector->vector = (double *) realloc(maxVector->vector,
+                                                   (curVector->len) * sizeof(double));
+        }
         if (maxVector->vector == NULL)
         {
             fprintf(stderr, "%s", ERR_MALLOC);
@@ -223,9 +441,66 @@ Vector *findMaxNormVectorInTree(RBTree *tree)
     }
     newVector->len = 0;
     newVector->vector = NULL;
+    if (tree->maxScoreFunc == vectorSquaredNorm)
+    {
+        // the tree already knows the vector, so only it is copied
+        const Vector *maxVector = maxNormVectorInTree(tree);
+        if (maxVector != NULL && copyIfNormIsLarger(maxVector, newVector) == 0)
+        {
+            return NULL;
+        }
+        return newVector;
+    }
     if (forEachRBTree(tree, copyIfNormIsLarger, newVector) == 0)
     {
         return NULL;
     }
     return newVector;
 }
+
+/**
+ * @brief ForEach function that keeps the given vector in pMaxVector if its norm is greater than
+ * the norm of the vector kept there, or if none is kept there yet
+ * @param pVector pointer to Vector
+ * @param pMaxVector pointer to a const Vector pointer
+ * @return 1 on success, 0 on failure (if pVector == NULL: failure).
+ */
+int keepIfNormIsLarger(const void *pVector, void *pMaxVector)
+{
+    const Vector *curVector = (const Vector *) pVector;
+    const Vector **maxVector = (const Vector **) pMaxVector;
+    if (curVector == NULL)
+    {
+        return FAILURE;
+    }
+    if (*maxVector == NULL || calculateNorm(curVector) > calculateNorm(*maxVector))
+    {
+        *maxVector = curVector;
+    }
+    return SUCCESS;
+}
+
+/**
+ * finds the vector that has the largest norm without copying it. takes O(1) if the tree was made
+ * with vectorSquaredNorm as its maxScoreFunc, and goes over the tree otherwise.
+ * @param tree a pointer to a tree of Vectors
+ * @return pointer to the vector itself (which still belongs to the tree), NULL if the tree is
+ * empty.
+ */
+const Vector *maxNormVectorInTree(RBTree *tree)
+{
+    if (tree == NULL)
+    {
+        return NULL;
+    }
+    if (tree->maxScoreFunc == vectorSquaredNorm)
+    {
+        return (const Vector *) maxScoreRBTree(tree);
+    }
+    const Vector *maxVector = NULL;
+    if (forEachRBTree(tree, keepIfNormIsLarger, &maxVector) == 0)
+    {
+        return NULL;
+    }
+    return maxVector;
+}
@@ -8,7 +8,8 @@
 #define TA_EX3_STRUCTS_H
 
 /**
- * Represents a vector. The double* should be dynamically allocated
+ * Represents a vector. The double* should be dynamically allocated, either on its own or together
+ * with the Vector, right after it (see newVector).
  */
 typedef struct Vector
 {
@@ -16,6 +17,18 @@ typedef struct Vector
 	double *vector;
 } Vector;
 
+/**
+ * The room for a string inside a node of a tree that keeps its items inside its nodes. Strings
+ * shorter than this are kept inside the node, so a node takes a single cache line.
+ */
+#define STRING_INLINE_SIZE (24)
+
+/**
+ * The room for a vector inside a node of a tree that keeps its items inside its nodes. Vectors of
+ * up to 4 coordinates are kept inside the node.
+ */
+#define VECTOR_INLINE_SIZE (sizeof(Vector) + 4 * sizeof(double))
+
 
 /**
  * CompFunc for strings (assumes strings end with "\0")
@@ -40,6 +53,38 @@ int concatenate(const void *word, void *pConcatenated); // implement it in Struc
  */
 void freeString(void *s); // implement it in Structs.c
 
+/**
+ * SizeFunc for strings
+ * @param s - char*
+ * @return the size of the string with its "\0"
+ */
+size_t stringSize(const void *s);
+
+/**
+ * InlineCopyFunc for strings. copies the string into the buffer if it fits there (with its
+ * "\0"), and to a new allocation otherwise.
+ * @param s - char* to copy
+ * @param buffer - the room inside the node
+ * @param bufferSize - the size of the room
+ * @return the copy, NULL on failure
+ */
+void *stringInlineCopy(const void *s, void *buffer, size_t bufferSize);
+
+/**
+ * CopyFunc for strings (see cloneRBTree). copies the string (with its "\0") to a new allocation.
+ * @param s - char* to copy
+ * @return the copy, NULL on failure
+ */
+void *stringCopy(const void *s);
+
+/**
+ * ArenaCopyFunc for strings. copies the string (with its "\0") into the arena.
+ * @param s - char* to copy
+ * @param arena - the arena of the tree
+ * @return the copy, NULL on failure
+ */
+void *stringArenaCopy(const void *s, Arena *arena);
+
 /**
  * CompFunc for Vectors, compares element by element, the vector that has the first larger
  * element is considered larger. If vectors are of different lengths and identify for the length
@@ -50,11 +95,77 @@ void freeString(void *s); // implement it in Structs.c
  */
 int vectorCompare1By1(const void *a, const void *b); // implement it in Structs.c
 
+/**
+ * Allocates a vector with a single allocation, that holds the Vector and its coordinates right
+ * after it. It is freed with freeVector, like any other vector.
+ * @param len - the amount of coordinates
+ * @param coordinates - the coordinates to copy into the vector (may be NULL to leave them unset)
+ * @return pointer to the new vector, NULL on failure
+ */
+Vector *newVector(int len, const double *coordinates);
+
 /**
  * FreeFunc for vectors
  */
 void freeVector(void *pVector); // implement it in Structs.c
 
+/**
+ * SizeFunc for vectors
+ * @param pVector - pointer to Vector
+ * @return the size of the Vector with its coordinates
+ */
+size_t vectorSize(const void *pVector);
+
+/**
+ * InlineCopyFunc for vectors. builds the copy (the Vector with its coordinates right after it)
+ * inside the buffer if it fits there, and allocates it like any other Vector otherwise.
+ * @param pVector - the vector to copy
+ * @param buffer - the room inside the node
+ * @param bufferSize - the size of the room
+ * @return the copy, NULL on failure
+ */
+void *vectorInlineCopy(const void *pVector, void *buffer, size_t bufferSize);
+
+/**
+ * CopyFunc for vectors (see cloneRBTree). allocates the copy like any other Vector.
+ * @param pVector - the vector to copy
+ * @return the copy, NULL on failure
+ */
+void *vectorCopy(const void *pVector);
+
+/**
+ * ArenaCopyFunc for vectors. builds the copy (the Vector with its coordinates right after it) in
+ * the arena.
+ * @param pVector - the vector to copy
+ * @param arena - the arena of the tree
+ * @return the copy, NULL on failure
+ */
+void *vectorArenaCopy(const void *pVector, Arena *arena);
+
+/**
+ * ScoreFunc for vectors, to be used as the maxScoreFunc of a tree of vectors (see
+ * maxNormVectorInTree).
+ * @param pVector - pointer to Vector
+ * @return the squared norm of the vector
+ */
+double vectorSquaredNorm(const void *pVector);
+
+/**
+ * AggregateItemFunc for vectors: the aggregate is a double, the squared norm of the vector. Used
+ * with sumAggregate, it gives the total squared norm of the vectors in a range.
+ * @param aggregate - pointer to double
+ * @param pVector - pointer to Vector
+ */
+void vectorNormAggregate(void *aggregate, const void *pVector);
+
+/**
+ * AggregateCombineFunc for aggregates that are a double: sums them.
+ * @param result - pointer to double, where to put the sum
+ * @param left - pointer to double
+ * @param right - pointer to double
+ */
+void sumAggregate(void *result, const void *left, const void *right);
+
 /**
  * copy pVector to pMaxVector if : 1. The norm of pVector is greater then the norm of pMaxVector.
  * 								   2. pMaxVector == NULL.
@@ -70,5 +181,14 @@ int copyIfNormIsLarger(const void *pVector, void *pMaxVector); // implement it i
  */
 Vector *findMaxNormVectorInTree(RBTree *tree); // implement it in Structs.c You must use copyIfNormIsLarger in the implementation!
 
+/**
+ * finds the vector that has the largest norm without copying it. takes O(1) if the tree was made
+ * with vectorSquaredNorm as its maxScoreFunc, and goes over the tree otherwise.
+ * @param tree a pointer to a tree of Vectors
+ * @return pointer to the vector itself (which still belongs to the tree), NULL if the tree is
+ * empty.
+ */
+const Vector *maxNormVectorInTree(RBTree *tree);
+
 
 #endif //TA_EX3_STRUCTS_H